@@ -13,8 +13,8 @@ namespace c1 {
 
 tee_time_t TeeFunctions::tee_get_trusted_time() {
   auto now = std::chrono::system_clock::now();
-  auto now_s = std::chrono::time_point_cast<std::chrono::seconds>(now);
-  auto value = now_s.time_since_epoch();
+  auto now_ms = std::chrono::time_point_cast<std::chrono::milliseconds>(now);
+  auto value = now_ms.time_since_epoch();
   return static_cast<tee_time_t>(value.count());
 }
 
@@ -41,7 +41,7 @@ class TeeFunctions {
 
 /**
  * Obtain the current elapsed time.
- * @return trusted time stamp in seconds relative to a reference point
+ * @return trusted time stamp in milliseconds relative to a reference point
  */
   static tee_time_t tee_get_trusted_time();
 
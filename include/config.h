@@ -19,8 +19,8 @@ constexpr int kX{2};
 /** variable epsilon as in the paper */
 constexpr double kEpsilon{.4};
 
-/** variable Delta as in the paper */
-constexpr int kDelta{4};
+/** default value of the variable Delta as in the paper, in milliseconds (see the --delta option of the login server) */
+constexpr int64_t kDefaultDelta{4000};
 /** variable A_max as in the paper */
 constexpr int kAMax{2};
 /** variable k_send as in the paper */
@@ -31,5 +31,7 @@ constexpr int kRecv{2};
 typedef int64_t round_t;
 typedef uint64_t onid_t;
 typedef int64_t dim_t;
+/** type of the ids of the peers (see PeerInformation::id) */
+typedef int64_t peer_id_t;
 
 #endif //CONFIG_H
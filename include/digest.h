@@ -0,0 +1,144 @@
+/**
+ * 128-bit content digests. They are used to index messages by their identity instead of comparing them byte by byte.
+ * The digest is not a cryptographic hash: equal digests are only a (very strong) hint for equal contents, so exact
+ * comparisons should still confirm a match where correctness depends on it.
+ */
+
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <tuple>
+
+namespace c1 {
+
+/**
+ * A 128-bit digest of a byte string.
+ */
+struct Digest {
+  uint64_t hi{};
+  uint64_t lo{};
+
+  bool operator==(const Digest &rhs) const { return hi == rhs.hi && lo == rhs.lo; }
+  bool operator!=(const Digest &rhs) const { return !(rhs == *this); }
+  bool operator<(const Digest &rhs) const { return std::tie(hi, lo) < std::tie(rhs.hi, rhs.lo); }
+};
+
+namespace digest_detail {
+
+inline uint64_t rotl64(uint64_t x, int8_t r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t fmix64(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+} // !namespace digest_detail
+
+/**
+ * Compute the digest of len bytes at data (this is MurmurHash3_x64_128).
+ * @param data
+ * @param len
+ * @param seed
+ * @return
+ */
+inline Digest compute_digest(const uint8_t *data, size_t len, uint64_t seed = 0) {
+  using digest_detail::rotl64;
+  using digest_detail::fmix64;
+  constexpr uint64_t c1 = 0x87c37b91114253d5ULL;
+  constexpr uint64_t c2 = 0x4cf5ad432745937fULL;
+
+  uint64_t h1 = seed;
+  uint64_t h2 = seed;
+  const size_t num_blocks = len / 16;
+
+  for (size_t i = 0; i < num_blocks; ++i) {
+    uint64_t k1;
+    uint64_t k2;
+    memcpy(&k1, data + i * 16, sizeof(k1));
+    memcpy(&k2, data + i * 16 + 8, sizeof(k2));
+
+    k1 *= c1;
+    k1 = rotl64(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+    h1 = rotl64(h1, 27);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52dce729;
+
+    k2 *= c2;
+    k2 = rotl64(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+    h2 = rotl64(h2, 31);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495ab5;
+  }
+
+  // tail (the remaining len % 16 bytes)
+  const uint8_t *tail = data + num_blocks * 16;
+  uint64_t k1 = 0;
+  uint64_t k2 = 0;
+  switch (len & 15U) {
+    case 15: k2 ^= static_cast<uint64_t>(tail[14]) << 48; [[fallthrough]];
+    case 14: k2 ^= static_cast<uint64_t>(tail[13]) << 40; [[fallthrough]];
+    case 13: k2 ^= static_cast<uint64_t>(tail[12]) << 32; [[fallthrough]];
+    case 12: k2 ^= static_cast<uint64_t>(tail[11]) << 24; [[fallthrough]];
+    case 11: k2 ^= static_cast<uint64_t>(tail[10]) << 16; [[fallthrough]];
+    case 10: k2 ^= static_cast<uint64_t>(tail[9]) << 8; [[fallthrough]];
+    case 9: k2 ^= static_cast<uint64_t>(tail[8]);
+      k2 *= c2;
+      k2 = rotl64(k2, 33);
+      k2 *= c1;
+      h2 ^= k2;
+      [[fallthrough]];
+    case 8: k1 ^= static_cast<uint64_t>(tail[7]) << 56; [[fallthrough]];
+    case 7: k1 ^= static_cast<uint64_t>(tail[6]) << 48; [[fallthrough]];
+    case 6: k1 ^= static_cast<uint64_t>(tail[5]) << 40; [[fallthrough]];
+    case 5: k1 ^= static_cast<uint64_t>(tail[4]) << 32; [[fallthrough]];
+    case 4: k1 ^= static_cast<uint64_t>(tail[3]) << 24; [[fallthrough]];
+    case 3: k1 ^= static_cast<uint64_t>(tail[2]) << 16; [[fallthrough]];
+    case 2: k1 ^= static_cast<uint64_t>(tail[1]) << 8; [[fallthrough]];
+    case 1: k1 ^= static_cast<uint64_t>(tail[0]);
+      k1 *= c1;
+      k1 = rotl64(k1, 31);
+      k1 *= c2;
+      h1 ^= k1;
+      break;
+    default: break;
+  }
+
+  // finalization
+  h1 ^= len;
+  h2 ^= len;
+  h1 += h2;
+  h2 += h1;
+  h1 = fmix64(h1);
+  h2 = fmix64(h2);
+  h1 += h2;
+  h2 += h1;
+
+  return Digest{h1, h2};
+}
+
+} // !namespace
+
+namespace std {
+template<>
+struct hash<c1::Digest> {
+  std::size_t operator()(const c1::Digest &k) const {
+    // the digest is already well-mixed, so any part of it is a good hash value
+    return static_cast<std::size_t>(k.lo);
+  }
+};
+}
+
+#endif //DIGEST_H
@@ -18,10 +18,11 @@
 #include "serialization.h"
 #include "config.h"
 #include "peer_information.h"
+#include "shared_functions.h"
 
 namespace c1 {
 
-enum MsgTypes { kTypeJoinMessage, kTypeInitMessage };
+enum MsgTypes { kTypeJoinMessage, kTypeInitMessage, kTypeTopologyMessage };
 
 /**
  * Returns the message type of a properly serialized message (where the type is encoded at the first four bytes).
@@ -68,17 +69,23 @@ struct JoinMessage : public Serializable {
 };;;
 
 /**
- * InitMessage sent from the login server to the peers to supply them with the init data.
+ * InitMessage sent from the login server to the peers to supply them with the init data that is specific to the
+ * receiver. It is followed by the TopologyMessage, from which the peer derives its gamma sets.
  */
 class InitMessage : public Serializable {
   int64_t receiver_id_;
   int64_t num_total_nodes_;
   int64_t overlay_dimension_;
+  /** m_corrupt to be used by the peers (0: derive it from num_total_nodes_) */
+  int64_t m_corrupt_;
+  /** max_routing_out to be used by the peers (0: derive it from num_total_nodes_) */
+  int64_t max_routing_out_;
+  /** Delta (see paper) in milliseconds */
+  int64_t delta_;
+  /** trusted time stamp (in milliseconds) at which round 0 starts, the same for all peers */
+  int64_t start_time_;
   onid_t onid_assoc_;
   onid_t onid_emul_;
-  std::vector<PeerInformation> gamma_send_{};
-  std::vector<PeerInformation> gamma_receive_{};
-  std::map<uint64_t, std::vector<PeerInformation>> gamma_route_{};
   std::array<uint8_t, kTee_aesgcm_key_size> sk_pseud_{};
   std::array<uint8_t, kTee_aesgcm_key_size> sk_enc_{};
   std::array<uint8_t, kTee_cmac_key_size> sk_routing_{};
@@ -92,20 +99,20 @@ class InitMessage : public Serializable {
   InitMessage(int64_t receiver_id_,
               int64_t num_total_nodes_,
               int64_t num_quorum_nodes_,
+              int64_t m_corrupt_,
+              int64_t max_routing_out_,
+              int64_t delta_,
+              int64_t start_time_,
               onid_t onid_assoc_,
               onid_t onid_emul_,
-              const std::vector<PeerInformation> &gamma_send_,
-              const std::vector<PeerInformation> &gamma_receive_,
-              const std::map<onid_t, std::vector<PeerInformation>> &gamma_route_,
               const std::array<uint8_t, kTee_aesgcm_key_size> sk_pseud_,
               const std::array<uint8_t, kTee_aesgcm_key_size> sk_enc_,
               const std::array<uint8_t, kTee_cmac_key_size> sk_routing_)
       : receiver_id_(receiver_id_), num_total_nodes_(num_total_nodes_),
         overlay_dimension_(num_quorum_nodes_),
+        m_corrupt_(m_corrupt_), max_routing_out_(max_routing_out_),
+        delta_(delta_), start_time_(start_time_),
         onid_assoc_(onid_assoc_), onid_emul_(onid_emul_),
-        gamma_send_(gamma_send_),
-        gamma_receive_(gamma_receive_),
-        gamma_route_(gamma_route_),
         sk_pseud_(sk_pseud_), sk_enc_(sk_enc_), sk_routing_(sk_routing_) {
     copy_crypto_keys();
   }
@@ -123,24 +130,28 @@ class InitMessage : public Serializable {
     return overlay_dimension_;
   }
 
-  onid_t get_onid_assoc_() const {
-    return onid_assoc_;
+  int64_t get_m_corrupt_() const {
+    return m_corrupt_;
   }
 
-  onid_t get_onid_emul_() const {
-    return onid_emul_;
+  int64_t get_max_routing_out_() const {
+    return max_routing_out_;
+  }
+
+  int64_t get_delta_() const {
+    return delta_;
   }
 
-  const std::vector<PeerInformation> &get_gamma_send_() const {
-    return gamma_send_;
+  int64_t get_start_time_() const {
+    return start_time_;
   }
 
-  const std::vector<PeerInformation> &get_gamma_receive_() const {
-    return gamma_receive_;
+  onid_t get_onid_assoc_() const {
+    return onid_assoc_;
   }
 
-  const std::map<uint64_t, std::vector<PeerInformation>> &get_gamma_route_() const {
-    return gamma_route_;
+  onid_t get_onid_emul_() const {
+    return onid_emul_;
   }
 
   tee_aes_gcm_128bit_key_t &get_sk_pseud_() {
@@ -159,11 +170,12 @@ class InitMessage : public Serializable {
     serialize_number(working_vec, receiver_id_);
     serialize_number(working_vec, num_total_nodes_);
     serialize_number(working_vec, overlay_dimension_);
+    serialize_number(working_vec, m_corrupt_);
+    serialize_number(working_vec, max_routing_out_);
+    serialize_number(working_vec, delta_);
+    serialize_number(working_vec, start_time_);
     serialize_number(working_vec, onid_assoc_);
     serialize_number(working_vec, onid_emul_);
-    serialize_vec(working_vec, gamma_send_);
-    serialize_vec(working_vec, gamma_receive_);
-    serialize_map_of_vecs(working_vec, gamma_route_);
     working_vec.insert(working_vec.end(), sk_pseud_.begin(), sk_pseud_.end());
     working_vec.insert(working_vec.end(), sk_enc_.begin(), sk_enc_.end());
     working_vec.insert(working_vec.end(), sk_routing_.begin(), sk_routing_.end());
@@ -174,11 +186,12 @@ class InitMessage : public Serializable {
     auto receiver_id = deserialize_number<decltype(InitMessage::receiver_id_)>(working_vec, cur);
     auto num_total_nodes = deserialize_number<decltype(InitMessage::num_total_nodes_)>(working_vec, cur);
     auto overlay_dimension = deserialize_number<decltype(InitMessage::overlay_dimension_)>(working_vec, cur);
+    auto m_corrupt = deserialize_number<decltype(InitMessage::m_corrupt_)>(working_vec, cur);
+    auto max_routing_out = deserialize_number<decltype(InitMessage::max_routing_out_)>(working_vec, cur);
+    auto delta = deserialize_number<decltype(InitMessage::delta_)>(working_vec, cur);
+    auto start_time = deserialize_number<decltype(InitMessage::start_time_)>(working_vec, cur);
     auto onid_assoc = deserialize_number<decltype(InitMessage::onid_assoc_)>(working_vec, cur);
     auto onid_emul = deserialize_number<decltype(InitMessage::onid_emul_)>(working_vec, cur);
-    auto gamma_send = deserialize_vec<PeerInformation>(working_vec, cur);
-    auto gamma_receive = deserialize_vec<PeerInformation>(working_vec, cur);
-    auto gamma_route = deserialize_map_of_vecs<uint64_t, PeerInformation>(working_vec, cur);
 
     std::array<decltype(InitMessage::sk_pseud_)::value_type, kTee_aesgcm_key_size> sk_pseud;
     std::copy_n(std::make_move_iterator(working_vec.begin() + cur), sk_pseud.size(), sk_pseud.begin());
@@ -192,20 +205,20 @@ class InitMessage : public Serializable {
     std::copy_n(std::make_move_iterator(working_vec.begin() + cur), sk_routing.size(), sk_routing.begin());
     cur += sk_routing.size();
 
-    return InitMessage{receiver_id, num_total_nodes, overlay_dimension, onid_assoc, onid_emul,
-                       gamma_send, gamma_receive, gamma_route,
-                       sk_pseud, sk_enc, sk_routing};
+    return InitMessage{receiver_id, num_total_nodes, overlay_dimension, m_corrupt, max_routing_out, delta, start_time,
+                       onid_assoc, onid_emul, sk_pseud, sk_enc, sk_routing};
   };
 
   size_t estimate_size() const override {
     return sizeof(receiver_id_)
         + sizeof(num_total_nodes_)
         + sizeof(overlay_dimension_)
+        + sizeof(m_corrupt_)
+        + sizeof(max_routing_out_)
+        + sizeof(delta_)
+        + sizeof(start_time_)
         + sizeof(onid_assoc_)
         + sizeof(onid_emul_)
-        + estimate_vec_size(gamma_send_)
-        + estimate_vec_size(gamma_receive_)
-        + estimate_map_of_vecs_size(gamma_route_)
         + sizeof(decltype(sk_pseud_)::value_type) * sk_pseud_.size()
         + sizeof(decltype(sk_enc_)::value_type) * sk_enc_.size()
         + sizeof(decltype(sk_routing_)::value_type) * sk_routing_.size();
@@ -219,6 +232,95 @@ class InitMessage : public Serializable {
   }
 };
 
+/**
+ * TopologyMessage sent from the login server to all peers (after their InitMessage): the uris of all peers and the
+ * quorums they are associated to and emulate. It is the same for every peer, so the login server serializes it only
+ * once, and every peer derives its gamma sets from it (see get_gamma_sets()).
+ */
+class TopologyMessage : public Serializable {
+  /** the uris of the peers by their ids */
+  std::vector<Uri> uris_;
+  /** the quorum each peer is associated to, by the ids of the peers */
+  std::vector<onid_t> associated_quorums_;
+  /** the quorum each peer emulates, by the ids of the peers */
+  std::vector<onid_t> emulated_quorums_;
+
+ public:
+  TopologyMessage(std::vector<Uri> uris_, std::vector<onid_t> associated_quorums_, std::vector<onid_t> emulated_quorums_)
+      : uris_(std::move(uris_)),
+        associated_quorums_(std::move(associated_quorums_)),
+        emulated_quorums_(std::move(emulated_quorums_)) {
+    assert(this->uris_.size() == this->associated_quorums_.size()
+               && this->uris_.size() == this->emulated_quorums_.size());
+  }
+
+  static uint8_t get_type() { return kTypeTopologyMessage; }
+
+  size_t get_num_peers() const {
+    return uris_.size();
+  }
+
+  const std::vector<Uri> &get_uris_() const {
+    return uris_;
+  }
+
+  const std::vector<onid_t> &get_associated_quorums_() const {
+    return associated_quorums_;
+  }
+
+  const std::vector<onid_t> &get_emulated_quorums_() const {
+    return emulated_quorums_;
+  }
+
+  /**
+   * Derive the gamma sets of a peer (in the order of the ids of the peers).
+   * @param onid_assoc the quorum the peer is associated to
+   * @param onid_emul the quorum the peer emulates
+   * @param dimension the dimension of the overlay network
+   * @param gamma_send all peers that emulate onid_assoc
+   * @param gamma_receive all peers that are associated to onid_emul
+   * @param gamma_route for onid_emul and each of its neighbors, all peers that emulate it
+   */
+  void get_gamma_sets(onid_t onid_assoc,
+                      onid_t onid_emul,
+                      dim_t dimension,
+                      std::vector<PeerInformation> &gamma_send,
+                      std::vector<PeerInformation> &gamma_receive,
+                      std::map<onid_t, std::vector<PeerInformation>> &gamma_route) const {
+    for_all_neighbors(onid_emul, dimension, [&gamma_route](onid_t neighbor_quorum) { gamma_route[neighbor_quorum]; });
+    for (size_t id = 0; id < uris_.size(); ++id) {
+      PeerInformation peer(static_cast<int64_t>(id), uris_[id]);
+      if (emulated_quorums_[id] == onid_assoc) {
+        gamma_send.push_back(peer);
+      }
+      if (associated_quorums_[id] == onid_emul) {
+        gamma_receive.push_back(peer);
+      }
+      auto route_it = gamma_route.find(emulated_quorums_[id]);
+      if (route_it != gamma_route.end()) {
+        route_it->second.push_back(peer);
+      }
+    }
+  }
+
+  void serialize(std::vector<uint8_t> &working_vec) const override {
+    serialize_vec(working_vec, uris_);
+    serialize_vec(working_vec, associated_quorums_);
+    serialize_vec(working_vec, emulated_quorums_);
+  }
+
+  static TopologyMessage deserialize(const std::vector<uint8_t> &working_vec, size_t &cur) {
+    auto uris = deserialize_vec<Uri>(working_vec, cur);
+    auto associated_quorums = deserialize_vec<onid_t>(working_vec, cur);
+    auto emulated_quorums = deserialize_vec<onid_t>(working_vec, cur);
+    return TopologyMessage{std::move(uris), std::move(associated_quorums), std::move(emulated_quorums)};
+  }
+
+  size_t estimate_size() const override {
+    return estimate_vec_size(uris_) + estimate_vec_size(associated_quorums_) + estimate_vec_size(emulated_quorums_);
+  }
+};
+
 /**
  * Used by the peer interface to obtain the relevant information for a sendMessage.
  */
@@ -238,7 +340,7 @@ class MessageSerializer {
     msg.serialize(working_vec);
   }
 
-  static std::variant<JoinMessage, InitMessage> deserialize_message(const std::vector<uint8_t> &working_vec,
+  static std::variant<JoinMessage, InitMessage, TopologyMessage> deserialize_message(const std::vector<uint8_t> &working_vec,
                                                                     size_t &cur) {
     auto type = deserialize_number<uint8_t>(working_vec, cur);
     if (type == kTypeJoinMessage) {
@@ -248,6 +350,9 @@ class MessageSerializer {
       auto msg = InitMessage::deserialize(working_vec, cur);
       return msg;
     }
+    if (type == kTypeTopologyMessage) {
+      return TopologyMessage::deserialize(working_vec, cur);
+    }
     assert(false);
   }
 
@@ -15,6 +15,7 @@
 #endif
 #include "serialization.h"
 #include "config.h"
+#include "digest.h"
 #include "../peer/trusted/helpers.h"
 #include "../peer/trusted/distributed_agreement_scheme.h"
 
@@ -196,6 +197,8 @@ class Message : public Serializable {
 
 /**
  * A Message tuple consisting of n_src, m, n_dst and t_dst. (see paper)
+ * Each tuple carries a digest of its contents, computed once on construction (and thus on decode). The fields must not
+ * be modified afterwards.
  */
 class MessageTuple : public Serializable {
  public:
@@ -204,8 +207,20 @@ class MessageTuple : public Serializable {
   Pseudonym n_dst;
   round_t t_dst;
 
+ private:
+  Digest digest_;
+
+ public:
   MessageTuple(const Pseudonym &n_src, const Message &m, const Pseudonym &n_dst, round_t t_dst)
-      : n_src(n_src), m(m), n_dst(n_dst), t_dst(t_dst) {}
+      : n_src(n_src), m(m), n_dst(n_dst), t_dst(t_dst), digest_(compute_tuple_digest()) {}
+
+  /**
+   * The digest identifying this tuple (equal tuples have equal digests).
+   * @return
+   */
+  const Digest &digest() const {
+    return digest_;
+  }
 
   bool operator<(const MessageTuple &rhs) const {
     return t_dst < rhs.t_dst;
@@ -224,7 +239,9 @@ class MessageTuple : public Serializable {
   }
 
   bool operator==(const MessageTuple &rhs) const {
-    return n_src == rhs.n_src &&
+    // the digests differ for (almost) all unequal tuples, so only matching tuples are compared byte by byte
+    return digest_ == rhs.digest_ &&
+        n_src == rhs.n_src &&
         m == rhs.m &&
         n_dst == rhs.n_dst &&
         t_dst == rhs.t_dst;
@@ -234,10 +251,10 @@ class MessageTuple : public Serializable {
     return !(rhs == *this);
   }
 
-  bool is_due(round_t cur_round, dim_t overlay_dimension, int64_t m_corrupt) const {
+  bool is_due(round_t cur_round, dim_t overlay_dimension, int64_t m_corrupt, int64_t delta) const {
     round_t l_delivered =
         cur_round + calculate_agreement_time(m_corrupt) + calculate_routing_time(overlay_dimension) + 3;
-    return (t_dst >= l_delivered * 4 * kDelta) && (t_dst < (l_delivered + 1) * 4 * kDelta);
+    return (t_dst >= l_delivered * 4 * delta) && (t_dst < (l_delivered + 1) * 4 * delta);
   }
 
   bool is_dummy() const {
@@ -268,11 +285,14 @@ class MessageTuple : public Serializable {
   };
 
   static MessageTuple create_dummy() {
-    return MessageTuple{Pseudonym::create_dummy(), Message::create_dummy(), Pseudonym::create_dummy(), 0};
+    // dummies are created in large numbers for padding, so their digest is computed only once
+    static const MessageTuple dummy{Pseudonym::create_dummy(), Message::create_dummy(), Pseudonym::create_dummy(), 0};
+    return dummy;
   }
 
   static MessageTuple create_cancel() {
-    return MessageTuple{Pseudonym::create_dummy(), Message::create_dummy(), Pseudonym::create_dummy(), 1};
+    static const MessageTuple cancel{Pseudonym::create_dummy(), Message::create_dummy(), Pseudonym::create_dummy(), 1};
+    return cancel;
   }
 
   std::string to_string() const {
@@ -297,6 +317,16 @@ class MessageTuple : public Serializable {
     return root;
   }
 #endif
+
+ private:
+  Digest compute_tuple_digest() const {
+    std::array<uint8_t, 2 * kPseudonymSize + kMessageSize + sizeof(round_t)> bytes{};
+    auto it = std::copy(n_src.get().begin(), n_src.get().end(), bytes.begin());
+    it = std::copy(m.get().begin(), m.get().end(), it);
+    it = std::copy(n_dst.get().begin(), n_dst.get().end(), it);
+    memcpy(&*it, &t_dst, sizeof(t_dst));
+    return compute_digest(bytes.data(), bytes.size());
+  }
 };
 
 /**
@@ -352,34 +382,39 @@ class AnnouncementTuple : public Serializable {
 
 /**
  * A structure used for the agreement scheme (sent between enclaves).
+ * All aware nodes that are sent to a receiver for the same message in one round are aggregated in one tuple.
  */
 class AgreementTuple : public Serializable {
  public:
   MessageTuple m;
   onid_t onid_src;
-  PeerInformation s;
+  /**
+   * id of the aware node (the sender only ever announces its own awareness, see DistributedAgreementScheme::update,
+   * so a single id is smaller than a bitmap over the participating nodes)
+   */
+  peer_id_t s;
   round_t l;
 
   AgreementTuple(const MessageTuple &m,
                  const onid_t &onid_src,
-                 const PeerInformation &s,
+                 peer_id_t s,
                  round_t l) : m(m), onid_src(onid_src), s(s), l(l) {}
 
   void serialize(std::vector<uint8_t> &working_vec) const override {
     m.serialize(working_vec);
     serialize_number(working_vec, onid_src);
-    s.serialize(working_vec);
+    serialize_number(working_vec, s);
     serialize_number(working_vec, l);
   }
 
   size_t estimate_size() const override {
-    return m.estimate_size() + sizeof(onid_src) + s.estimate_size() + sizeof(l);
+    return m.estimate_size() + sizeof(onid_src) + sizeof(s) + sizeof(l);
   }
 
   static AgreementTuple deserialize(const std::vector<uint8_t> &working_vec, size_t &cur) {
     auto m = MessageTuple::deserialize(working_vec, cur);
     auto onid_src = deserialize_number<onid_t>(working_vec, cur);
-    auto s = PeerInformation::deserialize(working_vec, cur);
+    auto s = deserialize_number<peer_id_t>(working_vec, cur);
     auto l = deserialize_number<round_t>(working_vec, cur);
     return AgreementTuple{m, onid_src, s, l};
   };
@@ -389,8 +424,8 @@ class AgreementTuple : public Serializable {
     Json::Value root;
     root["m"] = m.to_json_string();
     root["onid_src"] = std::to_string(onid_src);
-    static_assert(std::is_same<decltype(s.id), int64_t>::value); // manual check since implicit conversion to Json:Value is not possible
-    root["s"] = Json::Value::Int64(s.id);
+    static_assert(std::is_same<peer_id_t, int64_t>::value); // manual check since implicit conversion to Json:Value is not possible
+    root["s"] = Json::Value::Int64(s);
     root["l"] = std::to_string(l);
     return root;
   }
@@ -430,6 +465,15 @@ struct RoutingSchemeTuple : public Serializable {
     return !(*this < rhs);
   }
 
+  bool operator==(const RoutingSchemeTuple &rhs) const {
+    return std::tie(m, onid_dst, bucket_dst, l_dst, onid_current)
+        == std::tie(rhs.m, rhs.onid_dst, rhs.bucket_dst, rhs.l_dst, rhs.onid_current);
+  }
+
+  bool operator!=(const RoutingSchemeTuple &rhs) const {
+    return !(rhs == *this);
+  }
+
   void serialize(std::vector<uint8_t> &working_vec) const override {
     m.serialize(working_vec);
     serialize_number(working_vec, onid_dst);
@@ -474,6 +518,45 @@ struct RoutingSchemeTuple : public Serializable {
 
 };
 
+/**
+ * The routing tuples received from one peer in one round, together with the digest of their serialized form (which
+ * is computed once when the block is received, so that the majority vote over blocks does not need to compare them
+ * tuple by tuple).
+ */
+struct RoutingBlock {
+  std::vector<RoutingSchemeTuple> tuples;
+  Digest block_digest;
+
+  [[nodiscard]] const Digest &digest() const {
+    return block_digest;
+  }
+
+  bool operator==(const RoutingBlock &rhs) const {
+    return block_digest == rhs.block_digest && tuples == rhs.tuples;
+  }
+
+  bool operator!=(const RoutingBlock &rhs) const {
+    return !(rhs == *this);
+  }
+};
+
 }; // !namespace
 
+namespace std {
+template<>
+struct hash<c1::peer::Pseudonym> {
+  std::size_t operator()(const c1::peer::Pseudonym &k) const {
+    // (the first bytes of an encrypted pseudonym hold the lengths of its parts, so all bytes are hashed)
+    return hash<c1::Digest>{}(c1::compute_digest(k.get().data(), k.get().size()));
+  }
+};
+
+template<>
+struct hash<c1::peer::MessageTuple> {
+  std::size_t operator()(const c1::peer::MessageTuple &k) const {
+    return hash<c1::Digest>{}(k.digest());
+  }
+};
+}
+
 #endif //MISC_H
@@ -22,6 +22,7 @@
 #include <cstring>
 #include <map>
 #include <unordered_map>
+#include <type_traits>
 
 namespace c1 {
 
@@ -110,6 +111,38 @@ std::vector<T> deserialize_vec(const std::vector<uint8_t> &working_vec, size_t &
   return result;
 }
 
+/**
+ * Serialize a vector of integer numbers.
+ * @tparam T type of the elements in the vector
+ * @param working_vec byte vector which the serialized data is added to
+ * @param vec the vector to be serialized
+ */
+template<typename T, typename std::enable_if<std::is_integral<T>::value>::type * = nullptr>
+void
+serialize_vec(std::vector<uint8_t> &working_vec, const std::vector<T> &vec) {
+  serialize_number(working_vec, vec.size());
+  auto ptr = reinterpret_cast<const uint8_t *>(vec.data());
+  working_vec.insert(working_vec.end(), ptr, ptr + vec.size() * sizeof(T));
+}
+
+/**
+ * Deserialize a vector of integer numbers.
+ * @tparam T type of the elements in the vector
+ * @param working_vec vector holding the serialized data
+ * @param cur index of the first byte of the serialized vector in working_vec
+ * @return the deserialized vector
+ */
+template<typename T, typename std::enable_if<std::is_integral<T>::value>::type * = nullptr>
+std::vector<T> deserialize_vec(const std::vector<uint8_t> &working_vec, size_t &cur) {
+  auto size = deserialize_number<typename std::vector<T>::size_type>(working_vec, cur);
+  std::vector<T> result(size);
+  if (size != 0) {
+    memcpy(result.data(), &working_vec[cur], size * sizeof(T));
+  }
+  cur += size * sizeof(T);
+  return result;
+}
+
 /**
  * Serialize a map whose keys are Serializable objects or integer numbers and whose values are vectors of Serializable objects.
  * @tparam T1 key type
@@ -230,6 +263,18 @@ estimate_vec_size(const std::vector<T> &vec) {
   return result;
 }
 
+/**
+ * Calculate the size of the serialization of a vector of integer numbers.
+ * @tparam T type of the elements in vec
+ * @param vec
+ * @return
+ */
+template<typename T, typename std::enable_if<std::is_integral<T>::value>::type * = nullptr>
+size_t
+estimate_vec_size(const std::vector<T> &vec) {
+  return sizeof(size_t) + vec.size() * sizeof(T);
+}
+
 /**
  * Calculate the size of the serialization of map.
  * @tparam T1 key type
@@ -1,11 +1,13 @@
 /**
  * Author: Alexander S.
- * One helper function used in both the server and the client.
+ * Helper functions used in both the server and the client.
  */
 
 #ifndef SHARED_FUNCTIONS_H
 #define SHARED_FUNCTIONS_H
 
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include "config.h"
@@ -18,7 +20,7 @@ namespace c1 {
  * @param dimension the dimension of the overlay network
  * @param func the function to be called on onid' where onid' is a neighbor of node_id in the overlay network
  */
-void for_all_neighbors(onid_t node_id, dim_t dimension, std::function<void(onid_t)> func) {
+inline void for_all_neighbors(onid_t node_id, dim_t dimension, std::function<void(onid_t)> func) {
   func(node_id);
   for (dim_t i = 0; i < dimension; ++i) {
     onid_t node_id_i_th_bit_flipped = node_id ^1UL << i;
@@ -26,6 +28,40 @@ void for_all_neighbors(onid_t node_id, dim_t dimension, std::function<void(onid_
   }
 }
 
+/**
+ * Calculates the maxmium quorum size based on the total number of nodes.
+ * Typically, the result will be used in the calculate_max_routing_out function.
+ * @param num_nodes
+ * @return
+ */
+inline size_t calculate_max_quorum_size(int64_t num_nodes) {
+  return static_cast<size_t>(std::ceil((1 + 1.0 / (kX * kX)) * std::pow(log2(num_nodes), 1.0 + kEpsilon)));
+}
+
+/**
+ * Calculcate the maximum size of a single routing_out element (messages for routing_out to be send to a single peer).
+ * Note that this grows quickly with the dimension (e.g. 7598 for n = 81, d = 3); single-machine runs use a smaller
+ * value (see the --max-routing-out option of the login server).
+ * @param max_quorum_size the maximum quorum size
+ * @param overlay_dimension the dimension of the hypercube
+ * @return
+ */
+inline size_t calculate_max_routing_out(size_t max_quorum_size, dim_t overlay_dimension) {
+  auto b_max = max_quorum_size * kAMax;
+  return static_cast<size_t>(std::ceil(
+      8 * std::pow(overlay_dimension, kEpsilon + 2) * kRecv * b_max));
+}
+
+/**
+ * Calculate the maximum number of corrupted nodes m_corrupt (see paper) based on the total number of nodes.
+ * The login server clamps it to the size of the quorums (see LoginServerEnclave::resolve_system_parameters).
+ * @param num_nodes
+ * @return
+ */
+inline size_t calculate_m_corrupt(int64_t num_nodes) {
+  return static_cast<size_t>(std::floor(0.5 * (1.0 - 1.0 / (kX * kX)) * std::pow(log2(num_nodes), 1.0 + kEpsilon)));
+}
+
 } // !namespace
 
 #endif //SHARED_FUNCTIONS
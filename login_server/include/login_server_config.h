@@ -7,12 +7,32 @@
 
 namespace c1::login_server {
 
-/** currently hardcodes the dimension of the overlay network */
-constexpr int kDimension{3};
-/** currently hardcodes the desired number of nodes associated to each quorum */
-constexpr int kNumNodesPerQuorum{10};
-/** the total number of nodes in the overlay network */
-constexpr int kNumQuorumNodes = 1 << kDimension;
+/** default dimension of the overlay network (see the -d option of the login server) */
+constexpr int kDefaultDimension{3};
+/** default number of peers the login server waits for (see the -k option of the login server) */
+constexpr int kDefaultNumRequiredPeers{81};
+/** default m_corrupt of the peers (see the --m-corrupt option of the login server, 0 derives it from n) */
+constexpr int64_t kDefaultMCorrupt{1};
+/** default max_routing_out of the peers (see the --max-routing-out option of the login server, 0 derives it from n
+ * and d, which gives routing frames of several MB already for n = 81, d = 3) */
+constexpr int64_t kDefaultMaxRoutingOut{10};
+/** fixed part of the time (in milliseconds) between sending the init messages and the start of round 0, which is
+ * kStartDelay + n * kStartDelayPerPeer + 4 Delta so that the init messages of all n peers have been sent and processed
+ * well before the first round (a peer whose init message arrives after round 0 has started joins in a later round) */
+constexpr int64_t kStartDelay{3000};
+/** part of the start delay (in milliseconds) per peer, for sending its init message */
+constexpr int64_t kStartDelayPerPeer{5};
+/** how the login server assigns the peers to the quorums they are associated to and emulate */
+enum AssignmentMode {
+  /** associated: blocks of n / 2^d peers (the last quorum gets the remainder), emulated: independently at random */
+  kAssignmentRandom = 0,
+  /** both: a random permutation of the peers split into 2^d groups whose sizes differ by at most one */
+  kAssignmentBalanced = 1
+};
+/** default assignment mode (see the --assignment option of the login server) */
+constexpr AssignmentMode kDefaultAssignmentMode{kAssignmentBalanced};
+/** largest supported dimension of the overlay network (every quorum needs an associated peer, and the number of peers is an int) */
+constexpr int kMaxDimension{30};
 
 }
 
@@ -15,10 +15,19 @@ extern "C" {
 void ecall_init();
 void ecall_received_msg_from_client(const char* msg, size_t msg_len);
 int ecall_main_loop();
+int ecall_get_num_init_messages();
+void ecall_send_init_messages(int begin, int end);
 void ecall_kNumRequiredClients(int k);
+void ecall_set_system_parameters(int dimension,
+                                 int64_t m_corrupt,
+                                 int64_t max_routing_out,
+                                 int64_t delta,
+                                 int assignment_mode);
 
 void ocall_print_string(const char* str);
 void ocall_send_msg_to_peer(const char* client_uri, const char* msg, size_t msg_len);
+void ocall_publish_topology(const char* msg, size_t msg_len);
+void ocall_send_init_msg_to_peer(const char* client_uri, const char* msg, size_t msg_len);
 
 #ifdef __cplusplus
 }
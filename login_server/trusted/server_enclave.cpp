@@ -7,6 +7,7 @@
 
 
 #include "server_enclave.h"
+#include <algorithm>
 #include "enclave_t_substitute.h"
 #include "tee_functions.h"
 #include "cryptlib.h"
@@ -34,66 +35,160 @@ void LoginServerEnclave::received_msg_from_peer(const char *ptr, size_t len) {
       ocall_print_string(
           ("Current number of registered peers: " + std::to_string(peers_.size()) + "\n").c_str());
       if (peers_.size() >= numRequiredPeers_) {
-        initialize_system();
+        prepare_system_initialization();
       }
     }
   }
 }
 
 int LoginServerEnclave::main_loop() {
-  return !initialized_;
+  return !initialized_ && !rejected_;
 }
 
-void LoginServerEnclave::send_msg_to_peer(const std::string& peer_uri, char *msg_raw, int msg_len) const {
-  ocall_send_msg_to_peer(peer_uri.c_str(), msg_raw, msg_len);
+void LoginServerEnclave::send_init_msg_to_peer(const std::string& peer_uri, char *msg_raw, int msg_len) const {
+  ocall_send_init_msg_to_peer(peer_uri.c_str(), msg_raw, msg_len);
 }
 
-void LoginServerEnclave::initialize_system() {
+void LoginServerEnclave::assign_to_groups(std::vector<uint64_t> &groups, int num_groups) {
+  const auto n = static_cast<uint64_t>(groups.size());
+  std::vector<uint64_t> permutation(n);
+  for (uint64_t i = 0; i < n; ++i) {
+    permutation[i] = i;
+  }
+  // Fisher-Yates shuffle
+  for (uint64_t i = n; i > 1; --i) {
+    uint64_t random_number;
+    TeeFunctions::tee_read_rand(&random_number);
+    std::swap(permutation[i - 1], permutation[random_number % i]);
+  }
+  // position k of the permutation goes to group floor(k * num_groups / n), so the group sizes differ by at most one
+  for (uint64_t k = 0; k < n; ++k) {
+    groups[permutation[k]] = k * static_cast<uint64_t>(num_groups) / n;
+  }
+}
+
+void LoginServerEnclave::print_load_statistics(const std::vector<std::vector<PeerInformation>> &associated_quorums,
+                                               const std::vector<std::vector<PeerInformation>> &emulated_quorums) const {
+  auto print_min_avg_max = [](const std::string &what, const std::vector<size_t> &values) {
+    size_t min = values.empty() ? 0 : values.front();
+    size_t max = 0;
+    size_t sum = 0;
+    for (auto value : values) {
+      min = std::min(min, value);
+      max = std::max(max, value);
+      sum += value;
+    }
+    auto avg = values.empty() ? 0.0 : static_cast<double>(sum) / static_cast<double>(values.size());
+    ocall_print_string((what + ": min " + std::to_string(min) + ", avg " + std::to_string(avg) + ", max "
+        + std::to_string(max) + "\n").c_str());
+  };
+
+  std::vector<size_t> num_associated;
+  std::vector<size_t> num_emulating;
+  // the number of peers a peer emulating quorum q routes to (the gamma_route of the peers emulating q)
+  std::vector<size_t> route_fan_out;
+  for (onid_t quorum = 0; quorum < emulated_quorums.size(); ++quorum) {
+    num_associated.push_back(associated_quorums.at(quorum).size());
+    num_emulating.push_back(emulated_quorums.at(quorum).size());
+    size_t fan_out = 0;
+    for_all_neighbors(quorum, overlay_dimension_, [&fan_out, &emulated_quorums](onid_t neighbor_quorum) {
+      fan_out += emulated_quorums.at(neighbor_quorum).size();
+    });
+    route_fan_out.push_back(fan_out);
+  }
+  ocall_print_string((std::string("Quorum load (") + (assignment_mode_ == kAssignmentBalanced ? "balanced" : "random")
+      + " assignment):\n").c_str());
+  print_min_avg_max("  associated peers per quorum", num_associated);
+  print_min_avg_max("  emulating peers per quorum", num_emulating);
+  print_min_avg_max("  gamma_route size per quorum", route_fan_out);
+}
+
+bool LoginServerEnclave::resolve_system_parameters(const std::vector<std::vector<PeerInformation>> &associated_quorums,
+                                                   const std::vector<std::vector<PeerInformation>> &emulated_quorums) {
+  // (possible with the random assignment for small n)
+  for (onid_t quorum = 0; quorum < emulated_quorums.size(); ++quorum) {
+    if (associated_quorums.at(quorum).empty() || emulated_quorums.at(quorum).empty()) {
+      ocall_print_string(("Error: quorum " + std::to_string(quorum) + " has no associated or no emulating peers (use "
+          "more peers, a smaller dimension or the balanced assignment), not starting the system\n").c_str());
+      return false;
+    }
+  }
+
+  size_t min_emulating = emulated_quorums.front().size();
+  for (const auto &quorum : emulated_quorums) {
+    min_emulating = std::min(min_emulating, quorum.size());
+  }
+  // the largest m_corrupt for which the smallest quorum still has an honest majority
+  auto max_m_corrupt = static_cast<int64_t>((min_emulating - 1) / 2);
+  if (m_corrupt_ == 0) {
+    m_corrupt_ = std::min(static_cast<int64_t>(calculate_m_corrupt(numRequiredPeers_)), max_m_corrupt);
+  }
+  if (m_corrupt_ < 1 || m_corrupt_ > max_m_corrupt) {
+    ocall_print_string(("Error: m_corrupt = " + std::to_string(m_corrupt_) + " is not supported by the smallest quorum ("
+        + std::to_string(min_emulating) + " emulating peers, m_corrupt has to be in [1, "
+        + std::to_string(max_m_corrupt) + "]), not starting the system\n").c_str());
+    return false;
+  }
+  if (max_routing_out_ == 0) {
+    max_routing_out_ = static_cast<int64_t>(calculate_max_routing_out(calculate_max_quorum_size(numRequiredPeers_),
+                                                                      overlay_dimension_));
+  }
+  ocall_print_string(("Using m_corrupt = " + std::to_string(m_corrupt_) + ", max_routing_out = "
+      + std::to_string(max_routing_out_) + "\n").c_str());
+  return true;
+}
+
+void LoginServerEnclave::prepare_system_initialization() {
   ocall_print_string("Ready to initialize the system.\n");
 
   //Generate keys
-  std::array<uint8_t, kTee_aesgcm_key_size> sk_pseud = c1::cryptlib::keygen();
-  std::array<uint8_t, kTee_aesgcm_key_size> sk_enc = c1::cryptlib::keygen();
-  std::array<uint8_t, kTee_cmac_key_size> sk_routing = c1::cryptlib::gen_routing_key();
+  sk_pseud_ = c1::cryptlib::keygen();
+  sk_enc_ = c1::cryptlib::keygen();
+  sk_routing_ = c1::cryptlib::gen_routing_key();
 
   //Initialize overlay schemes
   for (int i = 0; i < peers_.size(); ++i) {
     peers_[i].id = i;
   }
 
-  std::vector<std::vector<PeerInformation>> associated_quorums; // stores, for each quorum, the associated nodes
-  std::vector<std::vector<PeerInformation>>
-      emulated_quorums(kNumQuorumNodes); // stores, for each quorum, the nodes emulating this quorum
+  const int num_quorum_nodes = 1 << overlay_dimension_;
+  assert(numRequiredPeers_ >= num_quorum_nodes);
   std::vector<uint64_t> peers_associated_quorums
-      (numRequiredPeers_); // stores redundant data, used for efficiency, maps each peer to its associated quorum
+      (numRequiredPeers_); // maps each peer to its associated quorum
   std::vector<uint64_t> peers_emulated_quorums
-      (numRequiredPeers_); // stores redundant data, used for efficiency, maps each peer to the quorum it emulates
+      (numRequiredPeers_); // maps each peer to the quorum it emulates
 
-  // determine a mapping for peers to associated quorums
-  for (int i = 0; i < kNumQuorumNodes; ++i) {
-    associated_quorums.emplace_back();
+  // note: in practice, the login server would not need to be seeded - here we just use a fixed value for now
+  TeeFunctions::seed(4711);
 
-    for (int j = i * kNumNodesPerQuorum;
-         j < (i + 1) * kNumNodesPerQuorum || (i == kNumQuorumNodes - 1 && j < numRequiredPeers_); ++j) {
-      associated_quorums.at(i).push_back(peers_.at(j));
-      peers_associated_quorums[j] = i;
+  if (assignment_mode_ == kAssignmentBalanced) {
+    assign_to_groups(peers_associated_quorums, num_quorum_nodes);
+    assign_to_groups(peers_emulated_quorums, num_quorum_nodes);
+  } else {
+    // every quorum gets num_nodes_per_quorum associated nodes, the last one additionally gets the remaining nodes
+    const int num_nodes_per_quorum = numRequiredPeers_ / num_quorum_nodes;
+    for (int j = 0; j < numRequiredPeers_; ++j) {
+      peers_associated_quorums[j] = std::min(j / num_nodes_per_quorum, num_quorum_nodes - 1);
+    }
+    // the quorums the peers emulate are chosen independently (so some may not be emulated at all for small n)
+    for (int i = 0; i < numRequiredPeers_; ++i) {
+      uint64_t random_number;
+      TeeFunctions::tee_read_rand(&random_number);
+      peers_emulated_quorums[i] = random_number % num_quorum_nodes;
     }
   }
-  // note: in practice, the login server would not need to be seeded - here we just use a fixed value for now
-  TeeFunctions::seed(4711);
 
-  // determine the mapping of peers to quorums they emulate
+  std::vector<std::vector<PeerInformation>>
+      associated_quorums(num_quorum_nodes); // stores, for each quorum, the associated nodes
+  std::vector<std::vector<PeerInformation>>
+      emulated_quorums(num_quorum_nodes); // stores, for each quorum, the nodes emulating this quorum
   for (int i = 0; i < numRequiredPeers_; ++i) {
-    uint64_t random_number;
-    TeeFunctions::tee_read_rand(&random_number);
-    uint64_t random_quorum = random_number % kNumQuorumNodes;
-    emulated_quorums.at(random_quorum).push_back(peers_.at(i));
-    peers_emulated_quorums[i] = random_quorum;
+    associated_quorums.at(peers_associated_quorums[i]).push_back(peers_.at(i));
+    emulated_quorums.at(peers_emulated_quorums[i]).push_back(peers_.at(i));
   }
 
   // output, for all quorums, which peers they are emulated by
-  for (int i = 0; i < kNumQuorumNodes; ++i) {
-    assert(!emulated_quorums.at(i).empty());
+  for (int i = 0; i < num_quorum_nodes; ++i) {
     ocall_print_string((std::string("Quorum ") + std::to_string(i) + " is emulated by: ").c_str());
     for (const auto &client : emulated_quorums.at(i)) {
       ocall_print_string((std::to_string(client.id) + ", ").c_str());
@@ -102,8 +197,7 @@ void LoginServerEnclave::initialize_system() {
   }
 
   // output, for all quorums, which peers are associated to them
-  for (int i = 0; i < kNumQuorumNodes; ++i) {
-    assert(!associated_quorums.at(i).empty());
+  for (int i = 0; i < num_quorum_nodes; ++i) {
     ocall_print_string((std::string("Nodes associated with quorum ") + std::to_string(i) + ": ").c_str());
     for (const auto &client : associated_quorums.at(i)) {
       ocall_print_string((std::to_string(client.id) + ", ").c_str());
@@ -111,6 +205,12 @@ void LoginServerEnclave::initialize_system() {
     ocall_print_string("\n");
   }
 
+  print_load_statistics(associated_quorums, emulated_quorums);
+  if (!resolve_system_parameters(associated_quorums, emulated_quorums)) {
+    rejected_ = true;
+    return;
+  }
+
 //  ocall_print_string(("gamma_send quorum of node 0: " + std::to_string(peers_associated_quorums[0]) + '\n').c_str());
 //  ocall_print_string(("gamma_receive quorum of node 0: " + std::to_string(peers_emulated_quorums[0]) + '\n').c_str());
 //  ocall_print_string("gamma_route neighbor quorums of node 0: ");
@@ -121,37 +221,68 @@ void LoginServerEnclave::initialize_system() {
 //                    });
 //  ocall_print_string("\n");
 
-  // send the init message to every peer:
-  for (int i = 0; i < numRequiredPeers_; ++i) {
+  // all peers start round 0 at the same time
+  start_time_ = static_cast<int64_t>(TeeFunctions::tee_get_trusted_time()) + kStartDelay
+      + numRequiredPeers_ * kStartDelayPerPeer + 4 * delta_;
+
+  // the topology is the same for all peers, they derive their gamma sets from it
+  std::vector<Uri> uris;
+  uris.reserve(peers_.size());
+  for (const auto &peer : peers_) {
+    uris.push_back(peer.uri);
+  }
+  TopologyMessage topology_message(std::move(uris), peers_associated_quorums, peers_emulated_quorums);
+  std::vector<uint8_t> topology_message_serialized;
+  topology_message_serialized.reserve(MessageSerializer::estimate_size(topology_message));
+  MessageSerializer::serialize_message(topology_message, topology_message_serialized);
+  ocall_publish_topology(reinterpret_cast<char *>(topology_message_serialized.data()),
+                         topology_message_serialized.size());
 
-    // gamma_send : all nodes that emulate the quorum node that i is associated with
-    std::vector<PeerInformation> gamma_send = emulated_quorums.at(peers_associated_quorums[i]);
-    // gamma_receive: all nodes that are associated with the quorum node that i emulates
-    std::vector<PeerInformation> gamma_receive = associated_quorums.at(peers_emulated_quorums[i]);
-    std::map<uint64_t, std::vector<PeerInformation>> gamma_route;
+  peers_associated_quorums_ = std::move(peers_associated_quorums);
+  peers_emulated_quorums_ = std::move(peers_emulated_quorums);
+  ready_to_initialize_ = true;
+}
 
-    for_all_neighbors(peers_emulated_quorums[i],
-                      kDimension,
-                      [&gamma_route, &emulated_quorums](uint64_t neighbor_quorum) {
-                        gamma_route[neighbor_quorum] = emulated_quorums.at(neighbor_quorum);
-                      });
+int LoginServerEnclave::num_pending_init_messages() const {
+  return ready_to_initialize_ && !initialized_ ? numRequiredPeers_ : 0;
+}
 
-    InitMessage init_message(peers_[i].id, numRequiredPeers_, kDimension,
-                             peers_associated_quorums[i], peers_emulated_quorums[i],
-                             gamma_send, gamma_receive, gamma_route, sk_pseud, sk_enc, sk_routing);
+void LoginServerEnclave::send_init_messages(int begin, int end) {
+  assert(ready_to_initialize_ && 0 <= begin && begin <= end && end <= numRequiredPeers_);
+  // only reads the state written by prepare_system_initialization(), so ranges can be sent concurrently
+  std::vector<uint8_t> init_message_serialized;
+  for (int i = begin; i < end; ++i) {
+    // only the data specific to peer i, the gamma sets are derived from the topology
+    InitMessage init_message(peers_[i].id, numRequiredPeers_, overlay_dimension_, m_corrupt_, max_routing_out_,
+                             delta_, start_time_, peers_associated_quorums_[i], peers_emulated_quorums_[i],
+                             sk_pseud_, sk_enc_, sk_routing_);
 
-    std::vector<uint8_t> init_message_serialized;
-    init_message_serialized.reserve(MessageSerializer::estimate_size(init_message));
+    init_message_serialized.clear();
     MessageSerializer::serialize_message(init_message, init_message_serialized);
-    send_msg_to_peer(peers_[i].uri,
-                     reinterpret_cast<char *>(init_message_serialized.data()),
-                     init_message_serialized.size());
+    send_init_msg_to_peer(peers_[i].uri,
+                          reinterpret_cast<char *>(init_message_serialized.data()),
+                          init_message_serialized.size());
+  }
+  // the caller that sends the last message completes the initialization
+  if (num_init_messages_sent_.fetch_add(end - begin) + (end - begin) == numRequiredPeers_) {
+    initialized_ = true;
   }
-  initialized_ = true;
 }
 
 void LoginServerEnclave::set_num_required_peers(int num) {
   numRequiredPeers_ = num;
 }
 
+void LoginServerEnclave::set_system_parameters(int dimension,
+                                               int64_t m_corrupt,
+                                               int64_t max_routing_out,
+                                               int64_t delta,
+                                               int assignment_mode) {
+  overlay_dimension_ = dimension;
+  m_corrupt_ = m_corrupt;
+  max_routing_out_ = max_routing_out;
+  delta_ = delta;
+  assignment_mode_ = assignment_mode;
+}
+
 } // ~namespace
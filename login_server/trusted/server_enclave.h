@@ -10,6 +10,8 @@
 
 #include <cstdlib>
 #include <cassert>
+#include <atomic>
+#include <map>
 #include <vector>
 #include <string>
 #include "../../include/message_structs.h"
@@ -42,7 +44,8 @@ class LoginServerEnclave {
 
   /**
    * Main loop function. Is supposed to be called regularly in the main while(true) loop.
-   * @return true as long as the system has not yet started (after which the login server can stop running).
+   * @return true as long as the system has not yet started (after which the login server can stop running) and the
+   * parameters have not been rejected by resolve_system_parameters().
    */
   int main_loop();
 
@@ -52,17 +55,101 @@ class LoginServerEnclave {
    */
   void set_num_required_peers(int num);
 
+  /**
+   * Set the parameters of the overlay network that are handed to the peers.
+   * @param dimension the dimension of the overlay network (i.e., there are 2^dimension quorums)
+   * @param m_corrupt m_corrupt of the peers (0: derived from the number of peers, see resolve_system_parameters())
+   * @param max_routing_out max_routing_out of the peers (0: derived from the number of peers and the dimension)
+   * @param delta Delta (see paper) in milliseconds, i.e., a round takes 4 * delta
+   * @param assignment_mode how the peers are assigned to quorums (see AssignmentMode)
+   */
+  void set_system_parameters(int dimension,
+                             int64_t m_corrupt,
+                             int64_t max_routing_out,
+                             int64_t delta,
+                             int assignment_mode);
+
+  /**
+   * @return the number of init messages to be sent with send_init_messages(), 0 unless all peers have joined and the
+   * init messages have not been sent yet
+   */
+  int num_pending_init_messages() const;
+
+  /**
+   * Build, serialize and send the init messages of the peers with ids in [begin, end) (each followed by the topology
+   * published by prepare_system_initialization()). May be called concurrently for
+   * disjoint ranges (every range has to be sent exactly once); the system is initialized once all have been sent.
+   * @param begin
+   * @param end
+   */
+  void send_init_messages(int begin, int end);
+
  private:
-  void send_msg_to_peer(const std::string& peer_uri, char *msg_raw, int msg_len) const;
-  /** Initiate the start of the system. Should be called when all peers have connected.  */
-  void initialize_system();
+  /** Send an init message to a peer, followed by the topology published by prepare_system_initialization(). */
+  void send_init_msg_to_peer(const std::string& peer_uri, char *msg_raw, int msg_len) const;
+  /**
+   * Assign the peers to quorums, generate the keys and publish the topology (serialized only once for all peers).
+   * Should be called when all peers have connected, the init messages are sent afterwards with send_init_messages().
+   */
+  void prepare_system_initialization();
+  /**
+   * Assign every element of groups (e.g. the peers) to one of num_groups groups: a random permutation of the elements
+   * is split into num_groups contiguous parts whose sizes differ by at most one.
+   * @param groups receives the group of each element
+   * @param num_groups
+   */
+  static void assign_to_groups(std::vector<uint64_t> &groups, int num_groups);
+  /**
+   * Output the minimum, average and maximum number of peers associated to and emulating the quorums, and the number
+   * of peers in the gamma_route of the peers emulating each quorum (the busiest quorum sets the round budget).
+   * @param associated_quorums for each quorum, the peers associated to it
+   * @param emulated_quorums for each quorum, the peers emulating it
+   */
+  void print_load_statistics(const std::vector<std::vector<PeerInformation>> &associated_quorums,
+                             const std::vector<std::vector<PeerInformation>> &emulated_quorums) const;
+  /**
+   * Replace m_corrupt_ and max_routing_out_ by the values the peers will use and check them against the quorums:
+   * every quorum needs associated and emulating peers, and the majority votes of a quorum fail unless 2 * m_corrupt
+   * is smaller than the number of peers emulating it. A derived m_corrupt is clamped to the smallest quorum, a given
+   * one that is too large is rejected.
+   * @param associated_quorums for each quorum, the peers associated to it
+   * @param emulated_quorums for each quorum, the peers emulating it
+   * @return false if the parameters have been rejected (no init messages must be sent then)
+   */
+  bool resolve_system_parameters(const std::vector<std::vector<PeerInformation>> &associated_quorums,
+                                 const std::vector<std::vector<PeerInformation>> &emulated_quorums);
 
   /** all peers yet connected */
   std::vector<PeerInformation> peers_; //very simple: each peer gets added with its uri and id
-  /** whether the system is already initialized () */
+  /** whether the system is already initialized (i.e., all init messages have been sent) */
   bool initialized_ = false;
+  /** whether prepare_system_initialization() has been called */
+  bool ready_to_initialize_ = false;
+  /** whether resolve_system_parameters() has rejected the parameters (the system is not started then) */
+  bool rejected_ = false;
+  /** number of init messages sent so far by send_init_messages() */
+  std::atomic<int> num_init_messages_sent_{0};
+  /** the quorum each peer is associated to (by the ids of the peers) */
+  std::vector<uint64_t> peers_associated_quorums_;
+  /** the quorum each peer emulates (by the ids of the peers) */
+  std::vector<uint64_t> peers_emulated_quorums_;
+  std::array<uint8_t, kTee_aesgcm_key_size> sk_pseud_{};
+  std::array<uint8_t, kTee_aesgcm_key_size> sk_enc_{};
+  std::array<uint8_t, kTee_cmac_key_size> sk_routing_{};
+  /** start of round 0 (in milliseconds of the trusted time) */
+  int64_t start_time_{};
   /** the number of peers required for the system to start running */
   int numRequiredPeers_{};
+  /** the dimension of the overlay network */
+  int overlay_dimension_{};
+  /** m_corrupt handed to the peers (0 until resolve_system_parameters(): derive it from the number of peers) */
+  int64_t m_corrupt_{};
+  /** max_routing_out handed to the peers (0 until resolve_system_parameters(): derive it from the number of peers) */
+  int64_t max_routing_out_{};
+  /** Delta handed to the peers (in milliseconds) */
+  int64_t delta_ = kDefaultDelta;
+  /** how the peers are assigned to quorums (see AssignmentMode) */
+  int assignment_mode_{};
 
 
 };
@@ -78,7 +165,24 @@ void ecall_received_msg_from_client(const char *ptr, size_t len) {
   c1::login_server::LoginServerEnclave::instance().received_msg_from_peer(ptr,
                                                                           len);}
 int ecall_main_loop() { return c1::login_server::LoginServerEnclave::instance().main_loop(); }
+int ecall_get_num_init_messages() {
+  return c1::login_server::LoginServerEnclave::instance().num_pending_init_messages();
+}
+void ecall_send_init_messages(int begin, int end) {
+  c1::login_server::LoginServerEnclave::instance().send_init_messages(begin, end);
+}
 void ecall_kNumRequiredClients(int k) { c1::login_server::LoginServerEnclave::instance().set_num_required_peers(k); }
+void ecall_set_system_parameters(int dimension,
+                                 int64_t m_corrupt,
+                                 int64_t max_routing_out,
+                                 int64_t delta,
+                                 int assignment_mode) {
+  c1::login_server::LoginServerEnclave::instance().set_system_parameters(dimension,
+                                                                         m_corrupt,
+                                                                         max_routing_out,
+                                                                         delta,
+                                                                         assignment_mode);
+}
 
 #if defined(__cplusplus)
 }
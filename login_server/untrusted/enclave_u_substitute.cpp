@@ -14,7 +14,14 @@ extern "C" {
 void ecall_init();
 void ecall_received_msg_from_client(const char *msg, size_t msg_len);
 int ecall_main_loop();
+int ecall_get_num_init_messages();
+void ecall_send_init_messages(int begin, int end);
 void ecall_kNumRequiredClients(int k);
+void ecall_set_system_parameters(int dimension,
+                                 int64_t m_corrupt,
+                                 int64_t max_routing_out,
+                                 int64_t delta,
+                                 int assignment_mode);
 
 #ifdef __cplusplus
 }
@@ -32,6 +39,23 @@ tee_status_t ecall_main_loop(tee_enclave_id_t eid, int *retval) {
   *retval = ecall_main_loop();
 }
 
+tee_status_t ecall_get_num_init_messages(tee_enclave_id_t eid, int *retval) {
+  *retval = ecall_get_num_init_messages();
+}
+
+tee_status_t ecall_send_init_messages(tee_enclave_id_t eid, int begin, int end) {
+  ecall_send_init_messages(begin, end);
+}
+
 tee_status_t ecall_kNumRequiredClients(tee_enclave_id_t eid, int k) {
   ecall_kNumRequiredClients(k);
 }
+
+tee_status_t ecall_set_system_parameters(tee_enclave_id_t eid,
+                                         int dimension,
+                                         int64_t m_corrupt,
+                                         int64_t max_routing_out,
+                                         int64_t delta,
+                                         int assignment_mode) {
+  ecall_set_system_parameters(dimension, m_corrupt, max_routing_out, delta, assignment_mode);
+}
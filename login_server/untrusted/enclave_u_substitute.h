@@ -14,7 +14,15 @@
 tee_status_t ecall_init(tee_enclave_id_t eid);
 tee_status_t ecall_received_msg_from_client(tee_enclave_id_t eid, const char* msg, size_t msg_len);
 tee_status_t ecall_main_loop(tee_enclave_id_t eid, int* retval);
+tee_status_t ecall_get_num_init_messages(tee_enclave_id_t eid, int* retval);
+tee_status_t ecall_send_init_messages(tee_enclave_id_t eid, int begin, int end);
 tee_status_t ecall_kNumRequiredClients(tee_enclave_id_t eid, int k);
+tee_status_t ecall_set_system_parameters(tee_enclave_id_t eid,
+                                         int dimension,
+                                         int64_t m_corrupt,
+                                         int64_t max_routing_out,
+                                         int64_t delta,
+                                         int assignment_mode);
 
 
 #endif //LOGIN_SERVER_ENCLAVE_U_SUBSTITUTE_H
@@ -3,17 +3,59 @@
  */
 
 #include "server.h"
+#include "login_server_config.h"
+#include "../../include/config.h"
 #include "../../include/CLI11.hpp"
 
 int main(int argc, char *argv[]) {
   using namespace c1::login_server;
 
   CLI::App app{"Login server"};
-  int required_clients = 81;
+  int required_clients = kDefaultNumRequiredPeers;
+  int dimension = kDefaultDimension;
+  int64_t m_corrupt = kDefaultMCorrupt;
+  int64_t max_routing_out = kDefaultMaxRoutingOut;
+  int64_t delta = kDefaultDelta;
+  std::string assignment = kDefaultAssignmentMode == kAssignmentBalanced ? "balanced" : "random";
   int port = 5671;
   app.add_option("-k", required_clients, "Number of the required clients");
+  app.add_option("-d,--dimension", dimension, "Dimension of the overlay network (there are 2^d quorums)");
+  app.add_option("--m-corrupt", m_corrupt, "m_corrupt of the peers (0: derive it from the number of clients)");
+  app.add_option("--max-routing-out",
+                 max_routing_out,
+                 "max_routing_out of the peers (0: derive it from the number of clients)");
+  app.add_option("--delta", delta, "Length of a subround (Delta) in milliseconds, a round takes 4 * Delta");
+  app.add_option("--assignment",
+                 assignment,
+                 "Assignment of the clients to quorums: balanced (equal group sizes) or random");
   app.add_option("-p", port, "Port the login_server will be listening on");
   CLI11_PARSE(app, argc, argv);
 
-  return LoginServer::instance().run(required_clients, port);
-}
\ No newline at end of file
+  if (dimension < 1 || dimension > kMaxDimension || required_clients < (1 << dimension)) {
+    std::cout << "Error: the dimension must be in [1, " << kMaxDimension
+              << "] and there must be at least 2^dimension clients" << std::endl;
+    return 1;
+  }
+  if (m_corrupt < 0 || max_routing_out < 0) {
+    std::cout << "Error: --m-corrupt and --max-routing-out must not be negative" << std::endl;
+    return 1;
+  }
+  if (delta < 1) {
+    std::cout << "Error: --delta must be positive" << std::endl;
+    return 1;
+  }
+
+  if (assignment != "balanced" && assignment != "random") {
+    std::cout << "Error: --assignment must be balanced or random" << std::endl;
+    return 1;
+  }
+  auto assignment_mode = assignment == "balanced" ? kAssignmentBalanced : kAssignmentRandom;
+
+  return LoginServer::instance().run(required_clients,
+                                     dimension,
+                                     m_corrupt,
+                                     max_routing_out,
+                                     delta,
+                                     assignment_mode,
+                                     port);
+}
@@ -9,6 +9,9 @@
 
 namespace c1::login_server {
 
+/** how long main_loop() waits for incoming messages (in ms) */
+static constexpr auto POLL_INTERVAL = 100;
+
 NetworkManagerLoginServer::NetworkManagerLoginServer()
     : context_(1), socket_in_(context_, ZMQ_ROUTER), peers_{}, global_sgx_eid_(0),
       pollitems_{static_cast<void *>(socket_in_), 0, ZMQ_POLLIN, 0} {
@@ -23,12 +26,14 @@ bool NetworkManagerLoginServer::main_loop() {
   }
   //static int run{0};
 
-  zmq::poll(&pollitems_[0], 1, 0);
+  zmq::poll(&pollitems_[0], 1, POLL_INTERVAL);
+  if (!(pollitems_[0].revents & ZMQ_POLLIN)) {
+    return true;
+  }
 
-  if (pollitems_[0].revents & ZMQ_POLLIN) {
+  // drain all pending messages (e.g. joins) without polling again
+  for (zmq::message_t msg_client_identity; socket_in_.recv(&msg_client_identity, ZMQ_DONTWAIT);) {
     // receive identity of peer
-    zmq::message_t msg_client_identity;
-    socket_in_.recv(&msg_client_identity);
     assert(msg_client_identity.more());
 
     // receive actual message content
@@ -50,17 +55,46 @@ void NetworkManagerLoginServer::set_port(int port) {
   port_ = port;
 }
 
-void NetworkManagerLoginServer::send_msg_to_client(const std::string &recipient, const char *ptr, size_t len) {
+zmq::socket_t &NetworkManagerLoginServer::socket_for_client(const std::string &recipient) {
+  zmq::socket_t *socket;
+  bool is_new;
+  {
+    // (references to the elements of the map stay valid when other elements are inserted)
+    std::lock_guard<std::mutex> lock(peers_mutex_);
+    auto peer_it = peers_.find(recipient);
+    is_new = peer_it == peers_.end();
+    if (is_new) {
+      peer_it = peers_.emplace(recipient, Peer{zmq::socket_t(context_, ZMQ_DEALER)}).first;
+    }
+    socket = &peer_it->second.socket;
+  }
   // if connection to recipient does not yet exist, establish it
-  if (peers_.count(recipient) < 1) {
-    peers_.emplace(recipient, Peer{zmq::socket_t(context_, ZMQ_DEALER)});
-    peers_.at(recipient).socket.connect("tcp://" + recipient);
+  if (is_new) {
+    socket->connect("tcp://" + recipient);
   }
+  return *socket;
+}
 
+void NetworkManagerLoginServer::send_msg_to_client(const std::string &recipient, const char *ptr, size_t len) {
   // send message to recipient
-  zmq::message_t message(len);
-  memcpy(message.data(), ptr, len);
-  peers_.at(recipient).socket.send(message);
+  zmq::message_t message(ptr, len);
+  socket_for_client(recipient).send(message);
+}
+
+void NetworkManagerLoginServer::send_init_msg_to_client(const std::string &recipient, const char *ptr, size_t len) {
+  auto &socket = socket_for_client(recipient);
+  zmq::message_t message(ptr, len);
+  socket.send(message, ZMQ_SNDMORE);
+  // copy() only adds a reference to the buffer of topology_ (and is thread-safe for the source message)
+  zmq::message_t topology;
+  topology.copy(&topology_);
+  socket.send(topology);
+}
+
+void NetworkManagerLoginServer::set_topology(const char *ptr, size_t len) {
+  topology_ = zmq::message_t(ptr, len);
+  // the first copy marks the buffer as shared (not thread-safe), later copies only increment the reference count
+  zmq::message_t{}.copy(&topology_);
 }
 
 } // ~namespace
@@ -8,6 +8,7 @@
 
 #include <zmq.h>
 #include <zmq.hpp>
+#include <mutex>
 #include <unordered_map>
 #include "../../../common/tee_functions.h"
 
@@ -42,26 +43,55 @@ class NetworkManagerLoginServer {
   void set_port(int port);
 
   /**
- * Called regularly.
+ * Called regularly: waits up to POLL_INTERVAL ms for messages and hands all of them to the enclave.
  * @return true
  */
   bool main_loop();
 
   /**
-   * Send message at ptr of length len to the peer with uri recipient.
+   * Send message at ptr of length len to the peer with uri recipient. Thread-safe as long as no two threads send to
+   * the same recipient concurrently (e.g. while sending the init messages in parallel).
    * @param recipient
    * @param ptr
    * @param len
    */
   void send_msg_to_client(const std::string &recipient, const char *ptr, size_t len);
 
+  /**
+   * Like send_msg_to_client(), but the message is followed by the topology (as a second frame of the same message,
+   * sharing the buffer set by set_topology() instead of copying it).
+   * @param recipient
+   * @param ptr
+   * @param len
+   */
+  void send_init_msg_to_client(const std::string &recipient, const char *ptr, size_t len);
+
+  /**
+   * Store the serialized topology (has to be called before send_init_msg_to_client()).
+   * @param ptr
+   * @param len
+   */
+  void set_topology(const char *ptr, size_t len);
+
  private:
+  /**
+   * Get the socket connected to recipient, connecting it if it does not exist yet (see send_msg_to_client() regarding
+   * thread-safety).
+   * @param recipient
+   * @return
+   */
+  zmq::socket_t &socket_for_client(const std::string &recipient);
+
   /** zeromq context */
   zmq::context_t context_;
   /** the incoming router socket */
   zmq::socket_t socket_in_;
   /** maps from URI to clients */
   std::unordered_map<std::string, Peer> peers_;
+  /** protects peers_ (not the sockets, each of them is only used by one thread at a time) */
+  std::mutex peers_mutex_;
+  /** the serialized topology, every init message shares its buffer */
+  zmq::message_t topology_;
   /** global sgx eid, to be able to make ecalls */
   tee_enclave_id_t global_sgx_eid_;
   /** port of the login_server */
@@ -6,15 +6,24 @@
 #include "server.h"
 #include "enclave_u_substitute.h"
 #include <pwd.h>
+#include <algorithm>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 namespace c1::login_server {
 
 LoginServer::LoginServer() : global_eid_(0), network_manager_() {}
 
-int LoginServer::run(int kNumRequiredPeers, int port) {
+int LoginServer::run(int kNumRequiredPeers,
+                     int dimension,
+                     int64_t m_corrupt,
+                     int64_t max_routing_out,
+                     int64_t delta,
+                     int assignment_mode,
+                     int port) {
   ecall_kNumRequiredClients(global_eid_, kNumRequiredPeers);
+  ecall_set_system_parameters(global_eid_, dimension, m_corrupt, max_routing_out, delta, assignment_mode);
   ecall_init(global_eid_);
 
   // Inform the network manager of the global_eid_
@@ -24,28 +33,52 @@ int LoginServer::run(int kNumRequiredPeers, int port) {
 
   std::cout << "Successfully initialized login_server!" << std::endl;
 
-  //main loop
+  //main loop (main_loop() waits for incoming messages, so there is no need to sleep here)
   while (true) {
     if (!network_manager_.main_loop()) {
       break;
     }
 
+    int num_init_messages;
+    ecall_get_num_init_messages(global_eid_, &num_init_messages);
+    if (num_init_messages > 0) {
+      send_init_messages(num_init_messages);
+    }
+
     int return_value;
     ecall_main_loop(global_eid_, &return_value);
     if (!return_value) {
       break;
     }
-
-    using namespace std::chrono_literals;
-    std::this_thread::sleep_for(0.01s);
   }
   return 0;
 }
 
+void LoginServer::send_init_messages(int num_init_messages) {
+  int num_threads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, num_init_messages);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    int begin = static_cast<int>(static_cast<int64_t>(num_init_messages) * t / num_threads);
+    int end = static_cast<int>(static_cast<int64_t>(num_init_messages) * (t + 1) / num_threads);
+    threads.emplace_back([this, begin, end] { ecall_send_init_messages(global_eid_, begin, end); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
 void LoginServer::send_msg_to_client(const std::string &recipient, const char *msg, size_t msg_len) {
   network_manager_.send_msg_to_client(recipient, msg, msg_len);
 }
 
+void LoginServer::send_init_msg_to_client(const std::string &recipient, const char *msg, size_t msg_len) {
+  network_manager_.send_init_msg_to_client(recipient, msg, msg_len);
+}
+
+void LoginServer::set_topology(const char *msg, size_t msg_len) {
+  network_manager_.set_topology(msg, msg_len);
+}
+
 } // ~namespace
 
 /* OCall functions */
@@ -58,3 +91,11 @@ void ocall_print_string(const char *str) {
 void ocall_send_msg_to_peer(const char *client_uri, const char *msg, size_t msg_len) {
   c1::login_server::LoginServer::instance().send_msg_to_client(client_uri, msg, msg_len);
 }
+
+void ocall_publish_topology(const char *msg, size_t msg_len) {
+  c1::login_server::LoginServer::instance().set_topology(msg, msg_len);
+}
+
+void ocall_send_init_msg_to_peer(const char *client_uri, const char *msg, size_t msg_len) {
+  c1::login_server::LoginServer::instance().send_init_msg_to_client(client_uri, msg, msg_len);
+}
@@ -30,10 +30,21 @@ class LoginServer {
   /**
    * Run the login server.
    * @param kNumRequiredPeers number of peers that the login server waits for until it issues the system to start.
+   * @param dimension dimension of the overlay network.
+   * @param m_corrupt m_corrupt to be used by the peers (0: derived from the number of peers).
+   * @param max_routing_out max_routing_out to be used by the peers (0: derived from the number of peers).
+   * @param delta Delta (see paper) to be used by the peers, in milliseconds.
+   * @param assignment_mode how the peers are assigned to quorums (see AssignmentMode).
    * @param port port the login server will be listening on.
    * @return 0 on normal termination.
    */
-  int run(int kNumRequiredPeers, int port);
+  int run(int kNumRequiredPeers,
+          int dimension,
+          int64_t m_corrupt,
+          int64_t max_routing_out,
+          int64_t delta,
+          int assignment_mode,
+          int port);
 
   /**
    * Send a message to the peer with uri recipient.
@@ -43,9 +54,31 @@ class LoginServer {
    */
   void send_msg_to_client(const std::string &recipient, const char *msg, size_t msg_len);
 
+  /**
+   * Send an init message to the peer with uri recipient, followed by the topology (see
+   * NetworkManagerLoginServer::set_topology()).
+   * @param recipient
+   * @param msg
+   * @param msg_len
+   */
+  void send_init_msg_to_client(const std::string &recipient, const char *msg, size_t msg_len);
+
+  /**
+   * Store the serialized topology to be sent to every peer along with its init message.
+   * @param msg
+   * @param msg_len
+   */
+  void set_topology(const char *msg, size_t msg_len);
+
  private:
   LoginServer();
 
+  /**
+   * Have the enclave send the init messages to all peers, split among one thread per core.
+   * @param num_init_messages
+   */
+  void send_init_messages(int num_init_messages);
+
   /** Global EID (enclave ID) shared by multiple threads */
   tee_enclave_id_t global_eid_ = 0;
 
@@ -62,6 +95,8 @@ extern "C" {
 
 void ocall_print_string(const char *str);
 void ocall_send_msg_to_peer(const char *client_uri, const char *msg, size_t msg_len);
+void ocall_publish_topology(const char *msg, size_t msg_len);
+void ocall_send_init_msg_to_peer(const char *client_uri, const char *msg, size_t msg_len);
 
 #if defined(__cplusplus)
 }
@@ -0,0 +1,153 @@
+/**
+ * Compares the ZeroMQ and the UDP transport over loopback: every round, a sender hands a number of equally sized
+ * frames to the transport and the time until the receiver has got all of them is measured.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include "../../include/CLI11.hpp"
+#include "../untrusted/network/udp_transport.h"
+#include "../untrusted/network/zmq_transport.h"
+
+using namespace c1;
+using namespace c1::peer;
+
+namespace {
+
+/** how long to wait for the remaining frames of a round before considering them lost */
+constexpr std::chrono::milliseconds kRoundTimeout{200};
+
+struct BenchmarkParameters {
+  int rounds = 100;
+  int frames_per_round = 500;
+  size_t frame_size = 1024;
+};
+
+struct BenchmarkResult {
+  std::chrono::nanoseconds total_round_time{0};
+  size_t num_lost = 0;
+};
+
+/**
+ * Run the rounds: sends via transport to peer and waits until received has been increased by the number of frames.
+ */
+BenchmarkResult run_rounds(const BenchmarkParameters &parameters,
+                           Transport &transport,
+                           const PeerInformation &peer,
+                           const std::atomic<size_t> &received) {
+  BenchmarkResult result;
+  std::vector<uint8_t> frame(parameters.frame_size, 0xc1);
+  size_t expected = 0;
+  for (int round = 0; round < parameters.rounds; ++round) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < parameters.frames_per_round; ++i) {
+      zmq::message_t payload(frame.data(), frame.size());
+      transport.send(peer, payload);
+    }
+    transport.flush();
+    expected += static_cast<size_t>(parameters.frames_per_round);
+
+    auto last_progress = std::chrono::steady_clock::now();
+    size_t num_received = received.load();
+    while (num_received < expected && std::chrono::steady_clock::now() - last_progress < kRoundTimeout) {
+      std::this_thread::yield();
+      auto now_received = received.load();
+      if (now_received != num_received) {
+        num_received = now_received;
+        last_progress = std::chrono::steady_clock::now();
+      }
+    }
+    result.total_round_time += std::chrono::steady_clock::now() - start;
+    if (num_received < expected) {
+      result.num_lost += expected - num_received;
+      expected = num_received;
+    }
+  }
+  return result;
+}
+
+void print_result(const std::string &name, const BenchmarkParameters &parameters, const BenchmarkResult &result) {
+  auto total_us = std::chrono::duration_cast<std::chrono::microseconds>(result.total_round_time).count();
+  auto num_frames = static_cast<double>(parameters.rounds) * parameters.frames_per_round;
+  std::cout << name << ": " << total_us / parameters.rounds << " us per round, "
+            << static_cast<int64_t>(num_frames / (static_cast<double>(total_us) / 1e6)) << " frames/s, "
+            << result.num_lost << " frames lost" << std::endl;
+}
+
+void benchmark_zmq(const BenchmarkParameters &parameters) {
+  zmq::context_t context;
+  zmq::socket_t receiver(context, ZMQ_DEALER);
+  receiver.setsockopt(ZMQ_LINGER, 0);
+  receiver.bind("tcp://127.0.0.1:*");
+  char endpoint[1024];
+  size_t size = sizeof(endpoint);
+  receiver.getsockopt(ZMQ_LAST_ENDPOINT, &endpoint, &size);
+  std::string endpoint_str(endpoint);
+  auto port = std::stoull(endpoint_str.substr(endpoint_str.find_last_of(':') + 1));
+
+  std::atomic<size_t> received{0};
+  std::atomic<bool> running{true};
+  std::thread receive_thread([&] {
+    zmq::pollitem_t pollitems[] = {{static_cast<void *>(receiver), 0, ZMQ_POLLIN, 0}};
+    while (running.load()) {
+      zmq::poll(&pollitems[0], 1, 10);
+      for (zmq::message_t message; receiver.recv(&message, ZMQ_DONTWAIT);) {
+        received.fetch_add(1);
+      }
+    }
+  });
+
+  ZmqTransport transport(context);
+  PeerInformation peer(1, Uri(127, 0, 0, 1, port));
+  transport.connect(peer);
+  auto result = run_rounds(parameters, transport, peer, received);
+  running = false;
+  receive_thread.join();
+  print_result("zmq", parameters, result);
+}
+
+void benchmark_udp(const BenchmarkParameters &parameters, int port) {
+  const std::array<uint8_t, 4> loopback{127, 0, 0, 1};
+  UdpTransport receiver(loopback, port, parameters.frame_size);
+  UdpTransport transport(loopback, port + 1, parameters.frame_size);
+
+  std::atomic<size_t> received{0};
+  std::atomic<bool> running{true};
+  std::thread receive_thread([&] {
+    while (running.load()) {
+      if (receiver.wait(10)) {
+        receiver.receive([&received](const uint8_t *, size_t) { received.fetch_add(1); });
+      }
+    }
+  });
+
+  PeerInformation peer(1, Uri(loopback[0], loopback[1], loopback[2], loopback[3], static_cast<uint64_t>(port)));
+  transport.connect(peer);
+  auto result = run_rounds(parameters, transport, peer, received);
+  running = false;
+  receive_thread.join();
+  print_result("udp", parameters, result);
+  std::cout << "udp: " << transport.num_datagrams_sent() << " datagrams in " << transport.num_batches_sent()
+            << " sendmmsg calls" << std::endl;
+}
+
+} // !namespace
+
+int main(int argc, char *argv[]) {
+  CLI::App app{"Transport benchmark"};
+  BenchmarkParameters parameters;
+  int udp_port = 47000;
+  app.add_option("-r,--rounds", parameters.rounds, "Number of rounds");
+  app.add_option("-f,--frames", parameters.frames_per_round, "Number of frames per round");
+  app.add_option("-s,--frame-size", parameters.frame_size, "Size of the frames in bytes");
+  app.add_option("-u,--udp-port", udp_port, "Port of the UDP receiver (the sender uses the next one)");
+  CLI11_PARSE(app, argc, argv)
+
+  std::cout << parameters.rounds << " rounds of " << parameters.frames_per_round << " frames of "
+            << parameters.frame_size << " bytes" << std::endl;
+  benchmark_zmq(parameters);
+  benchmark_udp(parameters, udp_port);
+  return 0;
+}
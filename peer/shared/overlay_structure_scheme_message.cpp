@@ -3,30 +3,87 @@
  * A message class used for the OverlayStructureScheme.
  */
 
+#include <algorithm>
 #include "overlay_structure_scheme_message.h"
 
 namespace c1::peer {
 
 void OverlayStructureSchemeMessage::serialize(std::vector<uint8_t> &working_vec) const {
+  working_vec.insert(working_vec.end(), encoded_->begin(), encoded_->end());
+}
+
+size_t OverlayStructureSchemeMessage::estimate_size() const {
+  return encoded_->size();
+}
+
+namespace {
+
+/**
+ * Append a bitmap over peer_table to working_vec, where bit i is set iff peer_table[i] is in peers.
+ * @param working_vec
+ * @param peer_table sorted table of peers
+ * @param peers
+ */
+void serialize_peer_bitmap(std::vector<uint8_t> &working_vec,
+                           const std::vector<PeerInformation> &peer_table,
+                           const std::vector<PeerInformation> &peers) {
+  auto bitmap_begin = working_vec.size();
+  working_vec.resize(bitmap_begin + (peer_table.size() + 7) / 8);
+  for (const auto &peer : peers) {
+    auto index = std::lower_bound(peer_table.begin(), peer_table.end(), peer) - peer_table.begin();
+    working_vec[bitmap_begin + index / 8] |= static_cast<uint8_t>(1U << (index % 8));
+  }
+}
+
+/**
+ * Deserialize a bitmap over peer_table (see serialize_peer_bitmap()).
+ * @param working_vec
+ * @param cur
+ * @param peer_table
+ * @return the peers whose bits are set (in the order of peer_table)
+ */
+std::vector<PeerInformation> deserialize_peer_bitmap(const std::vector<uint8_t> &working_vec,
+                                                     size_t &cur,
+                                                     const std::vector<PeerInformation> &peer_table) {
+  std::vector<PeerInformation> result;
+  for (size_t index = 0; index < peer_table.size(); ++index) {
+    if (working_vec[cur + index / 8] & (1U << (index % 8))) {
+      result.push_back(peer_table[index]);
+    }
+  }
+  cur += (peer_table.size() + 7) / 8;
+  return result;
+}
+
+} // !namespace
+
+void OverlayStructureSchemeMessage::encode() {
+  // table of all peers contained in the sets (sorted, so that the encoding does not depend on the order of the sets)
+  std::vector<PeerInformation> peer_table;
+  for (const auto &[_, peers] : gamma_route) {
+    peer_table.insert(peer_table.end(), peers.begin(), peers.end());
+  }
+  peer_table.insert(peer_table.end(), gamma_receive.begin(), gamma_receive.end());
+  std::sort(peer_table.begin(), peer_table.end());
+  peer_table.erase(std::unique(peer_table.begin(), peer_table.end()), peer_table.end());
+
+  std::vector<uint8_t> working_vec;
+  working_vec.reserve(sizeof(uint8_t) + sizeof(onid) + peer_information.estimate_size()
+                          + estimate_vec_size(peer_table) + sizeof(size_t)
+                          + (gamma_route.size() + 1) * (sizeof(onid_t) + (peer_table.size() + 7) / 8));
   serialize_number(working_vec, static_cast<uint8_t>(t));
   serialize_number(working_vec, onid);
   peer_information.serialize(working_vec);
+  serialize_vec(working_vec, peer_table);
   serialize_number(working_vec, gamma_route.size());
   for (auto&[onid, peer_information_vec] : gamma_route) {
     serialize_number(working_vec, onid);
-    serialize_vec(working_vec, peer_information_vec);
+    serialize_peer_bitmap(working_vec, peer_table, peer_information_vec);
   }
-  serialize_vec(working_vec, gamma_receive);
-}
+  serialize_peer_bitmap(working_vec, peer_table, gamma_receive);
 
-size_t OverlayStructureSchemeMessage::estimate_size() const {
-  auto result = sizeof(uint8_t) + sizeof(onid) + peer_information.estimate_size() + sizeof(size_t);
-  for (auto&[onid, peer_information_vec] : gamma_route) {
-    result += sizeof(onid);
-    result += estimate_vec_size(peer_information_vec);
-  }
-  result += estimate_vec_size(gamma_receive);
-  return result;
+  digest_ = compute_digest(working_vec.data(), working_vec.size());
+  encoded_ = std::make_shared<const std::vector<uint8_t>>(std::move(working_vec));
 }
 
 OverlayStructureSchemeMessage OverlayStructureSchemeMessage::deserialize(const std::vector<uint8_t> &working_vec,
@@ -35,12 +92,14 @@ OverlayStructureSchemeMessage OverlayStructureSchemeMessage::deserialize(const s
   result.t = static_cast<OverlayStructureSchemeMessageType>(deserialize_number<uint8_t>(working_vec, cur));
   result.onid = deserialize_number<decltype(result.onid)>(working_vec, cur);
   result.peer_information = PeerInformation::deserialize(working_vec, cur);
+  auto peer_table = deserialize_vec<PeerInformation>(working_vec, cur);
   auto gamma_route_size = deserialize_number<size_t>(working_vec, cur);
   for (int i = 0; i < gamma_route_size; ++i) {
     auto onid = deserialize_number<onid_t>(working_vec, cur);
-    result.gamma_route[onid] = deserialize_vec<PeerInformation>(working_vec, cur);
+    result.gamma_route[onid] = deserialize_peer_bitmap(working_vec, cur, peer_table);
   }
-  result.gamma_receive = deserialize_vec<PeerInformation>(working_vec, cur);
+  result.gamma_receive = deserialize_peer_bitmap(working_vec, cur, peer_table);
+  result.encode();
 
   return result;
 }
@@ -56,15 +115,16 @@ OverlayStructureSchemeMessage::OverlayStructureSchemeMessage(
       onid(onid),
       peer_information(peer_information),
       gamma_route(gamma_route),
-      gamma_receive(gamma_receive_or_send) {}
+      gamma_receive(gamma_receive_or_send) {
+  encode();
+}
 
 bool OverlayStructureSchemeMessage::operator<(const OverlayStructureSchemeMessage &rhs) const {
-  return std::tie(t, onid, peer_information, gamma_route, gamma_receive)
-      < std::tie(rhs.t,
-                 rhs.onid,
-                 rhs.peer_information,
-                 rhs.gamma_route,
-                 rhs.gamma_receive);
+  // the digests decide unless they are equal (in which case the messages are most likely equal as well)
+  if (std::tie(t, digest_) != std::tie(rhs.t, rhs.digest_)) {
+    return std::tie(t, digest_) < std::tie(rhs.t, rhs.digest_);
+  }
+  return *encoded_ < *rhs.encoded_;
 }
 
 bool OverlayStructureSchemeMessage::operator>(const OverlayStructureSchemeMessage &rhs) const {
@@ -6,15 +6,32 @@
 #ifndef OVERLAY_STRUCTURE_SCHEME_MESSAGE_H
 #define OVERLAY_STRUCTURE_SCHEME_MESSAGE_H
 
+#include <memory>
+#include "../../include/digest.h"
 #include "../../include/serialization.h"
 #include "../../include/message_structs.h"
 
 namespace c1::peer {
 // the following is not the nicest way of doing this, but it's keeping things simple for now
+/**
+ * Message of the overlay structure scheme.
+ * The sets of peers (gamma_route, gamma_receive) are encoded as a table of all peers they contain plus one bitmap
+ * over this table per set, so that every peer is sent only once. The encoding is computed once on construction
+ * (the fields must not be modified afterwards) and is shared between copies of the message. Its digest is used to
+ * compare messages quickly.
+ */
 class OverlayStructureSchemeMessage : public Serializable {
  private:
   OverlayStructureSchemeMessage() {}
 
+  /** the serialization of this message */
+  std::shared_ptr<const std::vector<uint8_t>> encoded_;
+  /** digest of encoded_ */
+  Digest digest_;
+
+  /** compute encoded_ and digest_ */
+  void encode();
+
  public:
   enum class OverlayStructureSchemeMessageType : uint8_t {
     tEmulateRequestMsg,
@@ -57,15 +74,18 @@ class OverlayStructureSchemeMessage : public Serializable {
 
   void serialize(std::vector<uint8_t> &working_vec) const override;
 
+  [[nodiscard]] const Digest &digest() const {
+    return digest_;
+  }
+
   static OverlayStructureSchemeMessage deserialize(const std::vector<uint8_t> &working_vec, size_t &cur);
 
+  /**
+   * Messages are compared by their encodings, which do not depend on the order of the peers in the sets (a decoded
+   * message has them in the order of the peer table, a constructed one in the order they were given).
+   */
   bool operator==(const OverlayStructureSchemeMessage &rhs) const {
-    return std::tie(t, onid, peer_information, gamma_route, gamma_receive)
-        == std::tie(rhs.t,
-                    rhs.onid,
-                    rhs.peer_information,
-                    rhs.gamma_route,
-                    rhs.gamma_receive);
+    return digest_ == rhs.digest_ && *encoded_ == *rhs.encoded_;
   }
   bool operator!=(const OverlayStructureSchemeMessage &rhs) const {
     return !(rhs == *this);
@@ -4,45 +4,62 @@
  * thorough documentation here. To understand the purpose and the realization of this class, please read the paper.
  */
 
+#include <algorithm>
 #include "distributed_agreement_scheme.h"
 
 namespace c1::peer {
 
-DistributedAgreementScheme::DistributedAgreementScheme() : set_s_i_() {}
-
-std::vector<DistributedAgreementSchemePair> DistributedAgreementScheme::update(bool aware,
-                                                                               const std::vector<PeerInformation> &participating_nodes,
-                                                                               PeerInformation own_id,
-                                                                               std::vector<PeerInformation> &s_m,
-                                                                               round_t l) {
-  std::vector<PeerInformation> s_out;
-  if (aware) { // init
-    set_s_i_.insert(own_id);
-    s_out.push_back(own_id);
+DistributedAgreementScheme::DistributedAgreementScheme(const std::vector<PeerInformation> &participating_nodes)
+    : aware_(participating_nodes.size()), num_aware_(0) {
+  participant_ids_.reserve(participating_nodes.size());
+  for (const auto &node : participating_nodes) {
+    participant_ids_.push_back(node.id);
   }
-  if (set_s_i_.empty()) {
-    set_s_i_.insert(own_id);
-    std::copy(set_s_i_.begin(), set_s_i_.end(), std::back_inserter(s_out));
-  } else if (!s_m.empty()) {
-    set_s_i_.insert(std::begin(s_m), std::end(s_m));
+  std::sort(participant_ids_.begin(), participant_ids_.end());
+}
+
+void DistributedAgreementScheme::insert(peer_id_t id) {
+  auto it = std::lower_bound(participant_ids_.begin(), participant_ids_.end(), id);
+  if (it != participant_ids_.end() && *it == id) {
+    auto bit = aware_[it - participant_ids_.begin()];
+    if (!bit) {
+      bit = true;
+      num_aware_++;
+    }
+  } else if (aware_others_.insert(id).second) {
+    num_aware_++;
   }
+}
 
-  std::vector<DistributedAgreementSchemePair> result;
-  for (auto &id : participating_nodes) {
-    for (auto &s : s_out) {
-      result.emplace_back(DistributedAgreementSchemePair{id, s});
+bool DistributedAgreementScheme::update(bool aware,
+                                        peer_id_t own_id,
+                                        const std::vector<peer_id_t> &s_m,
+                                        round_t l) {
+  bool send_own_id = false;
+  if (aware) { // init
+    insert(own_id);
+    send_own_id = true;
+  }
+  if (num_aware_ == 0) {
+    insert(own_id);
+    send_own_id = true;
+  } else {
+    for (auto id : s_m) {
+      insert(id);
     }
   }
 
-  return result;
+  return send_own_id;
 }
 
-bool DistributedAgreementScheme::finalize(PeerInformation own_id,
-                                          std::vector<PeerInformation> &s_m,
+bool DistributedAgreementScheme::finalize(peer_id_t own_id,
+                                          const std::vector<peer_id_t> &s_m,
                                           size_t t) {
-  set_s_i_.insert(std::begin(s_m), std::end(s_m));
-  set_s_i_.insert(own_id);
-  return set_s_i_.size() >= t + 1;
+  for (auto id : s_m) {
+    insert(id);
+  }
+  insert(own_id);
+  return num_aware_ >= t + 1;
 }
 
 } // !namespace
\ No newline at end of file
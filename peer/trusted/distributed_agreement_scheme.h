@@ -14,40 +14,46 @@
 
 namespace c1::peer {
 
-struct DistributedAgreementSchemePair {
-  PeerInformation receiver;
-  PeerInformation aware_node;
-};
-
 /**
  * The distributed agreement scheme.
  */
 class DistributedAgreementScheme {
  private:
-  /** see paper */
-  std::set<PeerInformation> set_s_i_;
+  /** ids of the participating nodes (sorted), the i-th id corresponds to the i-th bit of aware_ */
+  std::vector<peer_id_t> participant_ids_;
+  /** see paper (set S_i), stored as a bitmap over participant_ids_ */
+  std::vector<bool> aware_;
+  /** elements of S_i that are not among the participating nodes (usually none) */
+  std::set<peer_id_t> aware_others_;
+  /** size of S_i */
+  size_t num_aware_;
+
+  /**
+   * Add id to S_i.
+   * @param id
+   */
+  void insert(peer_id_t id);
 
  public:
-  DistributedAgreementScheme();
+  explicit DistributedAgreementScheme(const std::vector<PeerInformation> &participating_nodes);
 
   /**
    * see paper
    * @param aware
-   * @param participating_nodes
    * @param own_id
-   * @param s_m
+   * @param s_m the aware nodes received for this message
    * @param l
-   * @return
+   * @return whether own_id has to be sent to each of the participating nodes (S_out of the paper never contains
+   * another id)
    */
-  std::vector<DistributedAgreementSchemePair> update(bool aware,
-                                                     const std::vector<PeerInformation> &participating_nodes,
-                                                     PeerInformation own_id,
-                                                     std::vector<PeerInformation> &s_m,
-                                                     round_t l);
+  bool update(bool aware,
+              peer_id_t own_id,
+              const std::vector<peer_id_t> &s_m,
+              round_t l);
 
   /** see paper */
-  bool finalize(PeerInformation own_id,
-                std::vector<PeerInformation> &s_m,
+  bool finalize(peer_id_t own_id,
+                const std::vector<peer_id_t> &s_m,
                 size_t t);
 
 };
@@ -15,16 +15,22 @@ void ecall_init();
 void ecall_network_init(uint8_t ip1, uint8_t ip2, uint8_t ip3, uint8_t ip4, uint64_t port);
 void ecall_received_msg_from_server(const uint8_t *ptr, size_t len);
 int ecall_generate_pseudonym(uint8_t pseudonym[8]);
+size_t ecall_generate_pseudonyms(uint8_t *pseudonyms, size_t count);
 void ecall_send_message(uint8_t n_src[8], uint8_t msg[4], uint8_t n_dst[8], int64_t t_dst);
 int ecall_receive_message(uint8_t n_dst[8], uint8_t msg[4], uint8_t n_src[8], int64_t *t_dst);
 int ecall_traffic_out();
 void ecall_traffic_in(const uint8_t *ptr, size_t len);
 int64_t ecall_get_time();
+int64_t ecall_get_t_dst_lower_bound();
+int64_t ecall_get_next_round_time();
+void ecall_set_visualization(int enabled, uint32_t round_interval, uint32_t peer_modulus);
 
 void ocall_print_string(const char *str);
 void ocall_send_msg_to_server(const uint8_t *ptr, size_t len);
 void ocall_traffic_out_return(const uint8_t *ptr, size_t len);
+void ocall_connect_to_peers(const uint8_t *ptr, size_t len);
 void ocall_vis_data(const uint8_t *ptr, size_t len);
+void ocall_message_delivered(const uint8_t n_dst[8], int64_t t_dst);
 
 #ifdef __cplusplus
 }
@@ -17,20 +17,26 @@ void OverlayStructureScheme::init(uint64_t onid_assoc,
                                   round_t reconfiguration_time,
                                   round_t agreement_time,
                                   PeerInformation own_id) {
-  onid_assoc_ = onid_assoc;
-  onid_emul_new_ = onid_emul;
-  //gamma_agree_ = gamma_route.at(onid_emul);
-  gamma_send_new_ = gamma_send;
-  gamma_receive_ = gamma_receive;
-  gamma_receive_new_ = gamma_receive;
-  gamma_route_new_ = gamma_route;
-  // gamma_route_succ_ is empty
-  // gamma_route_prev_ is empty
-
   overlay_dimension_ = overlay_dimension;
   reconfiguration_time_ = reconfiguration_time;
   agreement_time_ = agreement_time;
 
+  onid_assoc_ = onid_assoc;
+  onid_emul_ = onid_emul; // replaced by onid_emul_new_ in the first update
+  onid_emul_new_ = onid_emul;
+  //gamma_agree_ = gamma_route.at(onid_emul);
+  gamma_send_new_ = PeerSet(gamma_send);
+  gamma_receive_ = PeerSet(gamma_receive);
+  gamma_receive_new_ = PeerSet(gamma_receive);
+  gamma_route_ = empty_quorum_peer_sets();
+  gamma_route_new_ = empty_quorum_peer_sets();
+  for (const auto &[onid, peers] : gamma_route) {
+    gamma_route_new_.at(onid).insert(peers.begin(), peers.end());
+  }
+  gamma_route_succ_ = empty_quorum_peer_sets();
+  gamma_route_prev_ = empty_quorum_peer_sets();
+  gamma_agree_prev_ = empty_quorum_peer_sets();
+
   own_id_ = std::move(own_id);
 }
 
@@ -51,11 +57,8 @@ OverlayReturnTuple OverlayStructureScheme::update(round_t round,
 
     // (b)
     onid_emul_ = onid_emul_new_;
-    gamma_agree_.clear();
-    for (auto &i_prime : gamma_route_new_[onid_emul_]) {
-      gamma_agree_.push_back(i_prime);
-    }
-    gamma_send_ = std::move(gamma_send_new_);
+    gamma_agree_ = gamma_route_new_.at(onid_emul_).peers();
+    gamma_send_ = gamma_send_new_.peers();
     gamma_route_ = std::move(gamma_route_new_);
 
     // (c)
@@ -70,25 +73,21 @@ OverlayReturnTuple OverlayStructureScheme::update(round_t round,
 
     // (d)
     gamma_send_new_.clear();
-    gamma_route_new_.clear();
+    gamma_route_new_ = empty_quorum_peer_sets();
 
     // (e)
-    gamma_agree_prev_.clear();
-    for (auto &i_prime : gamma_route_succ_[onid_emul_prev_]) {
-      gamma_agree_prev_[onid_emul_prev_].push_back(i_prime);
-    }
+    gamma_agree_prev_ = empty_quorum_peer_sets();
+    gamma_agree_prev_.at(onid_emul_prev_) = gamma_route_succ_.at(onid_emul_prev_);
 
     // (f)
-    gamma_route_prev_.clear();
+    gamma_route_prev_ = empty_quorum_peer_sets();
     for_all_neighbors(onid_emul_prev_, overlay_dimension_, [this](onid_t
                                                                   neighbor) {
-      for (auto &i_prime : gamma_route_succ_[neighbor]) {
-        gamma_route_prev_[neighbor].push_back(i_prime);
-      }
+      gamma_route_prev_.at(neighbor) = gamma_route_succ_.at(neighbor);
     });
 
     // (g)
-    gamma_route_succ_.clear();
+    gamma_route_succ_ = empty_quorum_peer_sets();
 
     // (h)
     msg_out_q[onid_emul_new_].push_back(OverlayStructureSchemeMessage::createEmulateRequestMsg(onid_emul_new_,
@@ -98,17 +97,14 @@ OverlayReturnTuple OverlayStructureScheme::update(round_t round,
   // (4)
   if (round % (reconfiguration_time_ / 2) == 2) {
     gamma_receive_ = std::move(gamma_receive_new_);
-    gamma_receive_new_.clear();
-    gamma_route_prev_.clear();
+    gamma_receive_new_ = PeerSet();
     gamma_route_prev_ = gamma_route_;
   }
 
   // (5)
   if (round % (reconfiguration_time_ / 2) == agreement_time_ + 1) {
-    gamma_agree_prev_.clear();
-    for (auto &i_prime : gamma_route_[onid_emul_]) {
-      gamma_agree_prev_[onid_emul_].push_back(i_prime);
-    }
+    gamma_agree_prev_ = empty_quorum_peer_sets();
+    gamma_agree_prev_.at(onid_emul_) = gamma_route_.at(onid_emul_);
   }
 
   // (6)
@@ -131,38 +127,29 @@ OverlayReturnTuple OverlayStructureScheme::update(round_t round,
 
     // (b)
     if (s.t == OverlayStructureSchemeMessage::OverlayStructureSchemeMessageType::tEmulateRequestReceivedMsg) {
-      gamma_route_succ_[s.onid].push_back(s.peer_information);
+      gamma_route_succ_.at(s.onid).insert(s.peer_information);
     }
 
     // (c)
     if (s.t == OverlayStructureSchemeMessage::OverlayStructureSchemeMessageType::tHandOverMsg) {
       for (auto&[onid, ids] : s.gamma_route) {
-        for (auto &elem : ids) {
-          if (std::find(gamma_route_new_[onid].begin(), gamma_route_new_[onid].end(), elem)
-              == gamma_route_new_[onid].end()) { // do not add elements twice
-            gamma_route_new_[onid].push_back(elem);
-          }
-        }
-      }
-      for (auto &elem : s.gamma_receive) {
-        if (std::find(gamma_receive_new_.begin(), gamma_receive_new_.end(), elem)
-            == gamma_receive_new_.end()) { // do not add elements twice
-          gamma_receive_new_.push_back(elem);
-        }
+        gamma_route_new_.at(onid).insert(ids.begin(), ids.end()); // (elements are not added twice)
       }
+      gamma_receive_new_.insert(s.gamma_receive.begin(), s.gamma_receive.end());
     }
 
     // (d)
     if (s.t == OverlayStructureSchemeMessage::OverlayStructureSchemeMessageType::tSelfIntroduceMsg) {
-      gamma_send_new_.push_back(s.peer_information);
+      gamma_send_new_.insert(s.peer_information);
     }
   }
 
   // (7)
   if (round % (reconfiguration_time_ / 2) == overlay_dimension_ + 2) {
-    for (auto &i_prime: gamma_route_succ_[onid_emul_]) {
-      s_prime[i_prime].push_back(OverlayStructureSchemeMessage::createHandOverMessage(gamma_route_succ_,
-                                                                                      gamma_receive_));
+    auto hand_over_message = OverlayStructureSchemeMessage::createHandOverMessage(to_map(gamma_route_succ_),
+                                                                                  gamma_receive_.peers());
+    for (auto &i_prime: gamma_route_succ_.at(onid_emul_)) {
+      s_prime[i_prime].push_back(hand_over_message);
     }
   }
 
@@ -187,7 +174,7 @@ OverlayReturnTuple OverlayStructureScheme::update(round_t round,
       }
     }
     for (const auto &msg: msgs) {
-      for (const auto &i_prime : gamma_route_[onid_prime]) {
+      for (const auto &i_prime : gamma_route_.at(onid_prime)) {
         s_prime[i_prime].push_back(msg);
       }
     }
@@ -195,24 +182,42 @@ OverlayReturnTuple OverlayStructureScheme::update(round_t round,
 
   // (10)
   auto gamma_route_result = gamma_route_;
-  for (const auto&[onid, ids] : gamma_agree_prev_) {
-    for (auto &id: ids) {
-      if (std::find(gamma_route_result[onid].begin(), gamma_route_result[onid].end(), id)
-          == gamma_route_result[onid].end()) { // I know this is inefficient ...
-        gamma_route_result[onid].push_back(id);
-      }
-    }
+  for (size_t onid = 0; onid < gamma_route_result.size(); ++onid) {
+    gamma_route_result[onid].insert(gamma_agree_prev_[onid].begin(), gamma_agree_prev_[onid].end());
+    gamma_route_result[onid].insert(gamma_route_prev_[onid].begin(), gamma_route_prev_[onid].end());
   }
-  for (const auto&[onid, ids] : gamma_route_prev_) {
-    for (auto &id: ids) {
-      if (std::find(gamma_route_result[onid].begin(), gamma_route_result[onid].end(), id)
-          == gamma_route_result[onid].end()) { // I know this is inefficient ...
-        gamma_route_result[onid].push_back(id);
-      }
+
+  return OverlayReturnTuple{onid_emul_, gamma_agree_, gamma_send_, to_map(gamma_route_result), gamma_receive_.peers(),
+                            s_prime};
+}
+
+void OverlayStructureScheme::collect_peers(PeerSet &peers) const {
+  peers.insert(gamma_send_.begin(), gamma_send_.end());
+  peers.insert(gamma_receive_.begin(), gamma_receive_.end());
+  peers.insert(gamma_send_new_.begin(), gamma_send_new_.end());
+  peers.insert(gamma_receive_new_.begin(), gamma_receive_new_.end());
+  for (const auto *sets : {&gamma_route_, &gamma_route_new_, &gamma_route_succ_}) {
+    for (const auto &set : *sets) {
+      peers.insert(set.begin(), set.end());
     }
   }
+}
+
+OverlayStructureScheme::QuorumPeerSets OverlayStructureScheme::empty_quorum_peer_sets() const {
+  return QuorumPeerSets(static_cast<size_t>(1) << overlay_dimension_);
+}
 
-  return OverlayReturnTuple{onid_emul_, gamma_agree_, gamma_send_, gamma_route_result, gamma_receive_, s_prime};
+std::map<onid_t, std::vector<PeerInformation>> OverlayStructureScheme::to_map(const QuorumPeerSets &sets) const {
+  std::map<onid_t, std::vector<PeerInformation>> result;
+  for (onid_t onid = 0; onid < sets.size(); ++onid) {
+    if (!sets[onid].empty()) {
+      result.emplace(onid, sets[onid].peers());
+    }
+  }
+  for_all_neighbors(onid_emul_, overlay_dimension_, [&result](onid_t neighbor) {
+    result[neighbor]; // make sure the entry exists
+  });
+  return result;
 }
 
 } // !namespace
\ No newline at end of file
@@ -13,16 +13,20 @@
 #include "../../include/message_structs.h"
 #include "../shared/overlay_structure_scheme_message.h"
 #include "../shared/overlay_return_tuple.h"
+#include "structs/peer_set.h"
 
 namespace c1::peer {
 
 class OverlayStructureScheme {
+  /** peer sets indexed by onid (one entry for each of the 2^overlay_dimension_ quorums) */
+  typedef std::vector<PeerSet> QuorumPeerSets;
+
   onid_t onid_assoc_;
   onid_t onid_emul_;
   std::vector<PeerInformation> gamma_agree_;
   std::vector<PeerInformation> gamma_send_;
-  std::vector<PeerInformation> gamma_receive_;
-  std::map<uint64_t, std::vector<PeerInformation>> gamma_route_;
+  PeerSet gamma_receive_;
+  QuorumPeerSets gamma_route_;
   int64_t overlay_dimension_;
   round_t reconfiguration_time_;
   round_t agreement_time_;
@@ -30,12 +34,23 @@ class OverlayStructureScheme {
 
   onid_t onid_emul_prev_;
   onid_t onid_emul_new_;
-  std::map<uint64_t, std::vector<PeerInformation>> gamma_agree_prev_;
-  std::vector<PeerInformation> gamma_send_new_;
-  std::map<uint64_t, std::vector<PeerInformation>> gamma_route_new_;
-  std::map<uint64_t, std::vector<PeerInformation>> gamma_route_succ_;
-  std::map<uint64_t, std::vector<PeerInformation>> gamma_route_prev_;
-  std::vector<PeerInformation> gamma_receive_new_;
+  QuorumPeerSets gamma_agree_prev_;
+  PeerSet gamma_send_new_;
+  QuorumPeerSets gamma_route_new_;
+  QuorumPeerSets gamma_route_succ_;
+  QuorumPeerSets gamma_route_prev_;
+  PeerSet gamma_receive_new_;
+
+  /** @return one empty set for each quorum */
+  [[nodiscard]] QuorumPeerSets empty_quorum_peer_sets() const;
+
+  /**
+   * Convert peer sets to the map representation used outside of this class. The map contains all non-empty sets and
+   * (possibly empty) entries for onid_emul_ and its neighbors.
+   * @param sets
+   * @return
+   */
+  [[nodiscard]] std::map<onid_t, std::vector<PeerInformation>> to_map(const QuorumPeerSets &sets) const;
 
  public:
   void init(uint64_t onid_assoc,
@@ -50,6 +65,13 @@ class OverlayStructureScheme {
 
   OverlayReturnTuple update(round_t round, const std::set<OverlayStructureSchemeMessage> &set_s);
 
+  /**
+   * Add all peers that this TEE currently communicates with or will communicate with after the ongoing
+   * reconfiguration (i.e., the gamma sets and their _new/_succ counterparts) to peers.
+   * @param peers
+   */
+  void collect_peers(PeerSet &peers) const;
+
 };
 
 } // !namespace
@@ -9,8 +9,10 @@
 #include "structs/aad_tuple.h"
 #include "routing_scheme.h"
 #include "../../common/cryptlib.h"
-#include "../include/vis_data.h"
 #include "../../include/receiver_blob_pair.h"
+#ifdef BUILD_WITH_VISUALIZATION
+#include "../include/vis_data.h"
+#endif
 
 // the following assert is defined via old-style DEFINE means because we cannot assume std::string to be available
 // inside the enclave (which for, e.g., Intel SGX is not the case)
@@ -48,10 +50,15 @@ void ClientEnclave::received_msg_from_login_server(const uint8_t *msg_ptr, size_
 
   if (std::holds_alternative<InitMessage>(msg)) {
     PRINT_CPP_STRING("Received init msg from login_server...\n");
-    auto current_time = TeeFunctions::tee_get_trusted_time();
-    init_time_ = current_time;
-
     auto &init_message = std::get<InitMessage>(msg);
+    // the topology follows the init message, the gamma sets of this peer are derived from it
+    auto topology_msg = MessageSerializer::deserialize_message(working_vec, cur);
+    assert(std::holds_alternative<TopologyMessage>(topology_msg));
+    const auto &topology_message = std::get<TopologyMessage>(topology_msg);
+
+    // all peers start their rounds at the same time (instead of at the time they received the init message)
+    init_time_ = static_cast<tee_time_t>(init_message.get_start_time_());
+    delta_ = init_message.get_delta_();
 
     memcpy(sk_pseud_, init_message.get_sk_pseud_(), kTee_aesgcm_key_size);
     memcpy(sk_enc_, init_message.get_sk_enc_(), kTee_aesgcm_key_size);
@@ -64,24 +71,46 @@ void ClientEnclave::received_msg_from_login_server(const uint8_t *msg_ptr, size_
 
     TeeFunctions::seed(own_id_.id);
 
+    // the parameters given by the login server take precedence over the ones derived from the number of nodes
+    auto num_total_nodes = init_message.get_num_total_nodes_();
+    m_corrupt_ = init_message.get_m_corrupt_() > 0 ? static_cast<size_t>(init_message.get_m_corrupt_())
+                                                   : calculate_m_corrupt(num_total_nodes);
+    max_quorum_size_ = calculate_max_quorum_size(num_total_nodes);
+    //PRINT_CPP_STRING("Calculated max_quorum_size is: " + std::to_string(max_quorum_size_) + '\n');
+    max_routing_msg_out_ = init_message.get_max_routing_out_() > 0
+                           ? static_cast<size_t>(init_message.get_max_routing_out_())
+                           : calculate_max_routing_out(max_quorum_size_, overlay_dimension_);
+    PRINT_CPP_STRING("Using m_corrupt = " + std::to_string(m_corrupt_) + ", max_routing_out = "
+                         + std::to_string(max_routing_msg_out_) + ", Delta = " + std::to_string(delta_) + " ms\n");
+
+    std::vector<PeerInformation> gamma_send;
+    std::vector<PeerInformation> gamma_receive;
+    std::map<onid_t, std::vector<PeerInformation>> gamma_route;
+    topology_message.get_gamma_sets(init_message.get_onid_assoc_(),
+                                    init_message.get_onid_emul_(),
+                                    overlay_dimension_,
+                                    gamma_send,
+                                    gamma_receive,
+                                    gamma_route);
+
     overlay_structure_scheme_.init(init_message.get_onid_assoc_(),
                                    init_message.get_onid_emul_(),
-                                   init_message.get_gamma_send_(),
-                                   init_message.get_gamma_receive_(),
-                                   init_message.get_gamma_route_(),
+                                   gamma_send,
+                                   gamma_receive,
+                                   gamma_route,
                                    overlay_dimension_,
                                    (overlay_dimension_ + 4) * 2,
                                    calculate_agreement_time(m_corrupt_),
                                    own_id_);
 
-    max_quorum_size_ = calculate_max_quorum_size(init_message.get_num_total_nodes_());
-    //PRINT_CPP_STRING("Calculated max_quorum_size is: " + std::to_string(max_quorum_size_) + '\n');
-
-    max_routing_msg_out_ = calculate_max_routing_out(max_quorum_size_, overlay_dimension_);
-
-    m_corrupt_ = calculate_m_corrupt(init_message.get_num_total_nodes_());
-
     initialized_ = true;
+    // a peer whose init message arrives after round 0 has started joins in the next round (the peers' clocks have to
+    // be synchronized, see the README)
+    if (get_time() > 0) {
+      cur_round_ = calculate_round_from_t(get_time(), delta_);
+      PRINT_CPP_STRING("Init message arrived late, joining in round " + std::to_string(cur_round_ + 1) + '\n');
+    }
+    connect_to_new_peers();
 
 //    ocall_print_string("PeerEnclave initialized Overlay Structure Scheme. \n");
   }
@@ -93,6 +122,26 @@ void ClientEnclave::try_and_send_msg_to_server(void *msg_raw, size_t msg_len) co
   ocall_send_msg_to_server(reinterpret_cast<uint8_t *>(msg_raw), msg_len);
 }
 
+void ClientEnclave::connect_to_new_peers() {
+  PeerSet peers;
+  overlay_structure_scheme_.collect_peers(peers);
+
+  std::vector<PeerInformation> new_peers;
+  for (const auto &peer : peers) {
+    if (peer.id != own_id_.id && connected_peers_.insert(peer)) {
+      new_peers.push_back(peer);
+    }
+  }
+  if (new_peers.empty()) {
+    return;
+  }
+
+  std::vector<uint8_t> serialized;
+  serialized.reserve(estimate_vec_size(new_peers));
+  serialize_vec(serialized, new_peers);
+  ocall_connect_to_peers(serialized.data(), serialized.size());
+}
+
 bool ClientEnclave::generate_pseudonym(uint8_t *pseudonym) {
   memset(pseudonym, 0, kPseudonymSize);
   if (pseudonyms_.size() >= kAMax) { // too many pseudonyms already
@@ -114,13 +163,34 @@ bool ClientEnclave::generate_pseudonym(uint8_t *pseudonym) {
             encrypted_pseudonym.begin() + std::min(kPseudonymSize, encrypted_pseudonym.size()),
             pseudonym);
 
+  local_pseudonyms_.emplace(Pseudonym{pseudonym}, pseudonyms_.size());
   pseudonyms_.push_back(pseud);
-  pseudonyms_enc_.push_back(encrypted_pseudonym);
   num_q_out_entries_for_round_for_pseudonym_.resize(num_q_out_entries_for_round_for_pseudonym_.size() + 1);
   q_in_for_pseudonyms_.resize(q_in_for_pseudonyms_.size() + 1);
   return true;
 }
 
+void ClientEnclave::set_visualization(bool enabled, uint32_t round_interval, uint32_t peer_modulus) {
+  vis_enabled_ = enabled;
+  vis_round_interval_ = std::max<uint32_t>(round_interval, 1);
+  vis_peer_modulus_ = std::max<uint32_t>(peer_modulus, 1);
+}
+
+size_t ClientEnclave::generate_pseudonyms(uint8_t *pseudonyms, size_t count) {
+  count = std::min(count, static_cast<size_t>(kAMax) - std::min(pseudonyms_.size(), static_cast<size_t>(kAMax)));
+  // grow the per-pseudonym structures once instead of once per pseudonym
+  pseudonyms_.reserve(pseudonyms_.size() + count);
+  local_pseudonyms_.reserve(local_pseudonyms_.size() + count);
+  num_q_out_entries_for_round_for_pseudonym_.reserve(num_q_out_entries_for_round_for_pseudonym_.size() + count);
+  q_in_for_pseudonyms_.reserve(q_in_for_pseudonyms_.size() + count);
+  for (size_t i = 0; i < count; ++i) {
+    if (!generate_pseudonym(pseudonyms + i * kPseudonymSize)) {
+      return i;
+    }
+  }
+  return count;
+}
+
 void ClientEnclave::send_message(uint8_t n_src[kPseudonymSize],
                                  uint8_t msg[kMessageSize],
                                  uint8_t n_dst[kPseudonymSize],
@@ -131,12 +201,12 @@ void ClientEnclave::send_message(uint8_t n_src[kPseudonymSize],
 
   ocall_print_string("Send_message called!\n");
 
-  auto pseud_n_src_decr = decrypt_pseudonym(Pseudonym{n_src});
   auto pseud_n_src = Pseudonym{n_src};
   auto msg_msg = Message{msg};
   auto pseud_n_dst = Pseudonym{n_dst};
 
-  if (std::find(pseudonyms_.begin(), pseudonyms_.end(), pseud_n_src_decr) == pseudonyms_.end()) {
+  auto local_n_src = local_pseudonyms_.find(pseud_n_src);
+  if (local_n_src == local_pseudonyms_.end()) {
     // this node does not have pseudonym n_src, abort
     ocall_print_string("Source pseudonym does not exist at this node!\n");
     return;
@@ -144,7 +214,7 @@ void ClientEnclave::send_message(uint8_t n_src[kPseudonymSize],
 
   if (t_dst < get_t_dst_lower_bound()) {
 //  if (get_time() > t_dst
-//      - (calculate_agreement_time(m_corrupt_) + calculate_routing_time(overlay_dimension_) + 4) * 4 * kDelta) {
+//      - (calculate_agreement_time(m_corrupt_) + calculate_routing_time(overlay_dimension_) + 4) * 4 * delta_) {
     // message is too late, abort
     ocall_print_string("Message is too late! Canceled ...\n");
     return;
@@ -152,9 +222,8 @@ void ClientEnclave::send_message(uint8_t n_src[kPseudonymSize],
 
   ocall_print_string("Message is not too late. It's being processed!\n");
 
-  auto l_dst = calculate_round_from_t(t_dst);
-  auto &num_entries_for_round =
-      num_q_out_entries_for_round_for_pseudonym_.at(pseud_n_src_decr.get_local_num());
+  auto l_dst = calculate_round_from_t(t_dst, delta_);
+  auto &num_entries_for_round = num_q_out_entries_for_round_for_pseudonym_.at(local_n_src->second);
   if (num_entries_for_round.count(static_cast<const unsigned long &>(l_dst)) != 0
       && num_entries_for_round[l_dst] >= kSend) {
     // too many message for that round already sent
@@ -181,43 +250,19 @@ int ClientEnclave::receive_message(uint8_t *n_dst,
 
   ocall_print_string("Trying to receive message...\n");
 
-  // check whether the decrypted version of the pseudonym does exist...
-  bool found = false;
-  for (auto enc_pseud : pseudonyms_enc_) {
-    found = true;
-    for (size_t i = 0; i < kPseudonymSize; ++i) {
-      if (i < enc_pseud.size()) {
-        if (enc_pseud[i] != n_dst[i]) {
-          found = false;
-          break;
-        }
-      } else if (n_dst[i] != 0) {
-        found = false;
-        break;
-      }
-    }
-    if (found) {
-      break;
-    }
-  }
-  if (!found) {
+  auto local_n_dst = local_pseudonyms_.find(Pseudonym{n_dst});
+  if (local_n_dst == local_pseudonyms_.end()) {
     ocall_print_string("This pseudonym does not exist!\n");
     return false;
   }
 
-  auto pseud_n_dst = decrypt_pseudonym(Pseudonym{n_dst});
-  if (std::find(pseudonyms_.begin(), pseudonyms_.end(), pseud_n_dst) == pseudonyms_.end()) {
-    // this node does not have pseudonym n_dst, abort
-    ocall_print_string("This pseudonym does not exist (double-check)!\n");
-    return false;
-  }
-
-  if (q_in_for_pseudonyms_.at(pseud_n_dst.get_local_num()).empty()) {
+  auto &q_in = q_in_for_pseudonyms_.at(local_n_dst->second);
+  if (q_in.empty()) {
     ocall_print_string("No message ready!\n");
     return false;
   }
 
-  auto &message_tuple = q_in_for_pseudonyms_.at(pseud_n_dst.get_local_num()).top();
+  auto &message_tuple = q_in.top();
   if (message_tuple.t_dst > get_time()) {
     // even the message with lowest t_dst is not due yet, abort
     ocall_print_string("No message ready!\n");
@@ -227,7 +272,7 @@ int ClientEnclave::receive_message(uint8_t *n_dst,
   std::copy(message_tuple.n_src.get().data(), message_tuple.n_src.get().data() + kPseudonymSize, n_src);
   *t_dst = message_tuple.t_dst;
 
-  q_in_for_pseudonyms_.at(pseud_n_dst.get_local_num()).pop();
+  q_in.pop();
   return true;
 }
 
@@ -236,8 +281,8 @@ int ClientEnclave::traffic_out() {
 
 //  PRINT_CPP_STRING("Invokation of traffic_out... time: " + std::to_string(get_time()) +"\n");
 
-  if (!initialized_) {
-    return false;
+  if (!initialized_ || TeeFunctions::tee_get_trusted_time() < init_time_) {
+    return false; // round 0 has not started yet
   }
 
   typedef std::map<PeerInformation, std::vector<MessageTuple>> default_out_t;
@@ -254,7 +299,7 @@ int ClientEnclave::traffic_out() {
   //ocall_print_string("test2\n");
 
   // establish a round model
-  auto subround = calculate_subround_from_t(get_time());
+  auto subround = calculate_subround_from_t(get_time(), delta_);
   if (subround % 4 != 0) {
     return false;
   }
@@ -267,7 +312,15 @@ int ClientEnclave::traffic_out() {
   ocall_print_string(std::string("\nsubround: " + std::to_string(subround) + "\n").c_str());
   ocall_print_string(std::string("this round is: " + std::to_string((cur_round_ + 1)) + "\n").c_str());
 
-  ASSERT(cur_round_ == (subround / 4) - 1) // otherwise, I am corrupted - so quit
+  if (cur_round_ < (subround / 4) - 1) {
+    // traffic_out was not called in time: skip the missed rounds, the messages buffered for them are outdated
+    auto num_missed = (subround / 4) - 1 - cur_round_;
+    ocall_print_string(("Missed " + std::to_string(num_missed) + " round(s), skipping them\n").c_str());
+    for (round_t i = 0; i < std::min<round_t>(num_missed, 2); ++i) {
+      advance_in_buffers();
+    }
+    cur_round_ = (subround / 4) - 1;
+  }
   cur_round_++;
 
   ocall_print_string(("traffic_out called ... in round " + std::to_string(cur_round_) + " (time "
@@ -288,7 +341,7 @@ int ClientEnclave::traffic_out() {
 
 //  ocall_print_string("test4\n");
   //announce outgoing messages
-  while (!q_out_.empty() && q_out_.top().is_due(cur_round_, overlay_dimension_, m_corrupt_)) {
+  while (!q_out_.empty() && q_out_.top().is_due(cur_round_, overlay_dimension_, m_corrupt_, delta_)) {
     ocall_print_string("Announcing a message!\n");
     for (auto &peer : overlay_result.gamma_send) {
       out_announce[peer].emplace_back(q_out_.top(), onid_repr_);
@@ -300,68 +353,83 @@ int ClientEnclave::traffic_out() {
   // start agreement for (other nodes') outgoing messages
   for (auto &announce: in_announce_[0]) {
 //    ocall_print_string("I received an announce message\n");
-    agreement_tuples_.emplace_back(AgreementLocalTuple{announce.m, true, DistributedAgreementScheme(),
+    agreement_tuples_.emplace_back(AgreementLocalTuple{announce.m, true,
+                                                       DistributedAgreementScheme(gamma_agree_for_round_.at(1)),
                                                        gamma_agree_for_round_.at(1), announce.onid_src, 0});
   }
 
 //  ocall_print_string("test6\n");
+  // group the received agreement messages by their message (once, the groups are used by all loops below)
+  struct AgreementGroup {
+    /** the aware nodes received for this message (s_m in the paper) */
+    std::vector<peer_id_t> s_m;
+    /** the first received agreement message that may start a new agreement for this message (nullptr if none) */
+    const AgreementTuple *first_eligible = nullptr;
+    /** whether this TEE already runs an agreement for this message */
+    bool running = false;
+  };
+  std::unordered_map<std::reference_wrapper<const MessageTuple>, AgreementGroup, std::hash<MessageTuple>,
+                     std::equal_to<MessageTuple>> agreement_groups(in_agreement_[0].size());
+  for (const auto &agreement: in_agreement_[0]) {
+    auto &group = agreement_groups[std::cref(agreement.m)];
+    group.s_m.push_back(agreement.s);
+    if (group.first_eligible == nullptr && agreement.l < calculate_agreement_time(m_corrupt_) - 1) {
+      group.first_eligible = &agreement;
+    }
+  }
+  const std::vector<peer_id_t> no_aware_nodes;
+  auto s_m_for = [&](const MessageTuple &message) -> const std::vector<peer_id_t> & {
+    auto it = agreement_groups.find(std::cref(message));
+    return it == agreement_groups.end() ? no_aware_nodes : it->second.s_m;
+  };
+
   // update running agreement schemes
+  for (const auto &elem: agreement_tuples_) {
+    auto it = agreement_groups.find(std::cref(elem.message));
+    if (it != agreement_groups.end()) {
+      it->second.running = true;
+    }
+  }
   for (auto &agreement: in_agreement_[0]) {
-    if (agreement.l < calculate_agreement_time(m_corrupt_) - 1) {
-      bool found = false;
-      for (auto &elem: agreement_tuples_) {
-        if (elem.message == agreement.m) {
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
-        agreement_tuples_.emplace_back(AgreementLocalTuple{agreement.m, false, DistributedAgreementScheme(),
-                                                           gamma_agree_for_round_.at(static_cast<unsigned long>(agreement.l)),
-                                                           agreement.onid_src,
-                                                           agreement.l - 1});
-      }
+    auto &group = agreement_groups.at(std::cref(agreement.m));
+    if (group.first_eligible == &agreement && !group.running) {
+      const auto &participating_nodes = gamma_agree_for_round_.at(static_cast<unsigned long>(agreement.l));
+      agreement_tuples_.emplace_back(AgreementLocalTuple{agreement.m, false,
+                                                         DistributedAgreementScheme(participating_nodes),
+                                                         participating_nodes,
+                                                         agreement.onid_src,
+                                                         agreement.l - 1});
+      group.running = true;
     }
   }
   for (auto &agreement_tuple: agreement_tuples_) {
-    // compute s_m
-    std::vector<PeerInformation> s_m;
-    for (auto &agreement_in: in_agreement_[0]) {
-      if (agreement_tuple.message == agreement_in.m) {
-        s_m.push_back(agreement_in.s);
-      }
-    }
+    const auto &s_m = s_m_for(agreement_tuple.message);
     // call update
-    auto new_agreement_messages = agreement_tuple.agreement_scheme.update(agreement_tuple.aware,
-                                                                          agreement_tuple.participating_nodes,
-                                                                          own_id_,
-                                                                          s_m,
-                                                                          agreement_tuple.round + 1);
+    bool send_own_id = agreement_tuple.agreement_scheme.update(agreement_tuple.aware,
+                                                               own_id_.id,
+                                                               s_m,
+                                                               agreement_tuple.round + 1);
     // update tuple
     agreement_tuple.round++;
     // reset state
     agreement_tuple.aware = false;
-    // add messages to out
-    for (auto &new_agreement_message : new_agreement_messages) {
-      out_agreement[new_agreement_message.receiver].emplace_back(AgreementTuple{agreement_tuple.message,
-                                                                                agreement_tuple.onid_src,
-                                                                                new_agreement_message.aware_node,
-                                                                                agreement_tuple.round + 1});
+    // add messages to out (one message per receiver)
+    if (send_own_id) {
+      for (auto &receiver : agreement_tuple.participating_nodes) {
+        out_agreement[receiver].emplace_back(AgreementTuple{agreement_tuple.message,
+                                                            agreement_tuple.onid_src,
+                                                            own_id_.id,
+                                                            agreement_tuple.round + 1});
+      }
     }
   }
 
   // finalize finished agreement scheme runs
   for (auto &agreement_tuple : agreement_tuples_) {
     if (agreement_tuple.round == calculate_agreement_time(m_corrupt_) - 1) {
-      // compute s_m
-      std::vector<PeerInformation> s_m;
-      for (auto &agreement_in: in_agreement_[0]) {
-        if (agreement_tuple.message == agreement_in.m) {
-          s_m.push_back(agreement_in.s);
-        }
-      }
+      const auto &s_m = s_m_for(agreement_tuple.message);
       // call finalize
-      bool v = agreement_tuple.agreement_scheme.finalize(own_id_,
+      bool v = agreement_tuple.agreement_scheme.finalize(own_id_.id,
                                                          s_m,
                                                          0); // TODO change to correct value after high performance test
       if (!v) {
@@ -388,7 +456,7 @@ int ClientEnclave::traffic_out() {
     auto in_inject_filtered = obtain_elements_that_exceed_m_corrupt<MessageTuple>(in_inject_[0]);
 //    PRINT_CPP_STRING("I have received that many inject messages: " + std::to_string(in_inject_filtered.size()) + '\n');
 
-    for (const auto &inject_message : in_inject_filtered) {
+    for (const MessageTuple &inject_message : in_inject_filtered) {
 //      PRINT_CPP_STRING("I have a valid injection message...\n");
       if (inject_message.is_dummy()) {
         continue; // ignore this message
@@ -408,13 +476,11 @@ int ClientEnclave::traffic_out() {
 //  ocall_print_string("test8\n");
   // route messages
 //  PRINT_CPP_STRING("Currently waiting there are " + std::to_string(in_routing_[0].size()) + " routing messages.\n");
-  auto s_primes =
-      obtain_elements_that_exceed_m_corrupt<std::vector<RoutingSchemeTuple>>(
-          in_routing_[0]);
+  auto s_primes = obtain_elements_that_exceed_m_corrupt<RoutingBlock>(in_routing_[0]);
 //  PRINT_CPP_STRING("s_primes: " + std::to_string(s_primes.size()) + "\n");
   std::vector<RoutingSchemeTuple> v_set;
-  for (const auto &s_uppercase : s_primes) {
-    for (const auto &s_lowercase : s_uppercase) {
+  for (const RoutingBlock &s_uppercase : s_primes) {
+    for (const auto &s_lowercase : s_uppercase.tuples) {
       v_set.push_back(s_lowercase);
 //      PRINT_CPP_STRING("s.l_dst: " + std::to_string(s_lowercase.l_dst) + "\n" );
     }
@@ -449,7 +515,7 @@ int ClientEnclave::traffic_out() {
   // deliver messages to final destination
   auto set_of_predeliver_messages = obtain_elements_that_exceed_m_corrupt<MessageTuple>(
       in_predeliver_[0]);
-  for (const auto &message : set_of_predeliver_messages) {
+  for (const MessageTuple &message : set_of_predeliver_messages) {
     if (!message.is_dummy()) {
       ocall_print_string("We have received a non-dummy predeliver-message ... \n");
       out_deliver[decrypt_pseudonym(message.n_dst).get_peer_information()].emplace_back(message);
@@ -605,67 +671,54 @@ int ClientEnclave::traffic_out() {
   output.reserve(estimate_vec_size(i_c_pairs));
   serialize_vec(output, i_c_pairs);
 
-  // move all in[1] to in[0]
-  in_structure_[0] = std::move(in_structure_[1]);
-  in_structure_[1].clear();
-  in_announce_[0] = std::move(in_announce_[1]);
-  in_announce_[1].clear();
-  in_agreement_[0] = std::move(in_agreement_[1]);
-  in_agreement_[1].clear();
-  in_inject_[0] = std::move(in_inject_[1]);
-  in_inject_[1].clear();
-  in_routing_[0] = std::move(in_routing_[1]);
-  in_routing_[1].clear();
-  in_predeliver_[0] = std::move(in_predeliver_[1]);
-  in_predeliver_[1].clear();
-  in_deliver_[0] = std::move(in_deliver_[1]);
-  in_deliver_[1].clear();
-  traffic_in_received_from_[0] = std::move(traffic_in_received_from_[1]);
-  traffic_in_received_from_[1].clear();
+  advance_in_buffers();
 
   // actually return the output
   ocall_traffic_out_return(output.data(), output.size());
+  // after the output (so that it is not delayed): connect to the peers that became known during this round
+  connect_to_new_peers();
 
-
-  //determine whether a message has to be sent:
-  bool has_waiting_message = false;
-  for (const auto &pseud: num_q_out_entries_for_round_for_pseudonym_) {
-    for (const auto&[round, num] : pseud) {
-      if (num > 0 && round >= calculate_round_from_t(get_t_dst_lower_bound())) {
-        has_waiting_message = true;
+#ifdef BUILD_WITH_VISUALIZATION
+  if (vis_enabled_ && cur_round_ % vis_round_interval_ == 0 && own_id_.id % vis_peer_modulus_ == 0) {
+    //determine whether a message has to be sent:
+    bool has_waiting_message = false;
+    for (const auto &pseud: num_q_out_entries_for_round_for_pseudonym_) {
+      for (const auto&[round, num] : pseud) {
+        if (num > 0 && round >= calculate_round_from_t(get_t_dst_lower_bound(), delta_)) {
+          has_waiting_message = true;
+        }
       }
     }
-  }
 
-  bool has_delivered_unready_message = false;
-  bool has_delivered_ready_message = false;
-  for (const auto &q_in : q_in_for_pseudonyms_) {
-    if (!q_in.empty()) {
-      if (q_in.top().t_dst > get_time()) {
-        has_delivered_unready_message = true;
-      } else {
-        has_delivered_ready_message = true;
+    bool has_delivered_unready_message = false;
+    bool has_delivered_ready_message = false;
+    for (const auto &q_in : q_in_for_pseudonyms_) {
+      if (!q_in.empty()) {
+        if (q_in.top().t_dst > get_time()) {
+          has_delivered_unready_message = true;
+        } else {
+          has_delivered_ready_message = true;
+        }
       }
     }
-  }
 
-#ifdef BUILD_WITH_VISUALIZATION
-  VisData vis_data(own_id_,
-                   onid_repr_,
-                   cur_round_,
-                   overlay_result,
-                   out_announce,
-                   out_agreement,
-                   out_inject,
-                   out_routing,
-                   out_predeliver,
-                   out_deliver,
-                   has_waiting_message,
-                   has_delivered_unready_message,
-                   has_delivered_ready_message);
-  std::vector<uint8_t> vis_data_serialized;
-  vis_data.serialize(vis_data_serialized);
-  ocall_vis_data(vis_data_serialized.data(), vis_data_serialized.size());
+    VisData vis_data(own_id_,
+                     onid_repr_,
+                     cur_round_,
+                     overlay_result,
+                     out_announce,
+                     out_agreement,
+                     out_inject,
+                     out_routing,
+                     out_predeliver,
+                     out_deliver,
+                     has_waiting_message,
+                     has_delivered_unready_message,
+                     has_delivered_ready_message);
+    std::vector<uint8_t> vis_data_serialized;
+    vis_data.serialize(vis_data_serialized);
+    ocall_vis_data(vis_data_serialized.data(), vis_data_serialized.size());
+  }
 #endif
 
   ocall_print_string("Finished TrafficOut()...\n");
@@ -697,7 +750,9 @@ void ClientEnclave::traffic_in(const uint8_t *ptr, size_t len) {
   auto p_announce = deserialize_vec<AnnouncementTuple>(p_decrypted, cur_p);
   auto p_agreement = deserialize_vec<AgreementTuple>(p_decrypted, cur_p);
   auto p_inject = deserialize_vec<MessageTuple>(p_decrypted, cur_p);
+  auto cur_p_routing = cur_p;
   auto p_routing = deserialize_vec<RoutingSchemeTuple>(p_decrypted, cur_p);
+  auto p_routing_digest = compute_digest(p_decrypted.data() + cur_p_routing, cur_p - cur_p_routing);
   auto p_predeliver = deserialize_vec<MessageTuple>(p_decrypted, cur_p);
   auto p_deliver = deserialize_vec<MessageTuple>(p_decrypted, cur_p);
 
@@ -716,7 +771,11 @@ void ClientEnclave::traffic_in(const uint8_t *ptr, size_t len) {
   }
 
   auto cur_or_next = aad.round - cur_round_ - 1; // compute whether in[0] or in[1] needs to be used
-  ASSERT(cur_or_next < 2)
+  if (cur_or_next >= 2) {
+    // this TEE is behind (it will skip the rounds it missed in traffic_out)
+    ocall_print_string("Received a message for a round this TEE has not reached yet ...\n");
+    return;
+  }
 
   if (traffic_in_received_from_[cur_or_next][aad.sender]) {
     ocall_print_string("Received a message a second time ...\n");
@@ -731,7 +790,9 @@ void ClientEnclave::traffic_in(const uint8_t *ptr, size_t len) {
                                     std::begin(p_agreement),
                                     std::end(p_agreement));
   in_inject_[cur_or_next].insert(std::end(in_inject_[cur_or_next]), std::begin(p_inject), std::end(p_inject));
-  in_routing_[cur_or_next].push_back(std::move(p_routing));
+  if (!p_routing.empty()) { // empty blocks are dummies
+    in_routing_[cur_or_next].push_back(RoutingBlock{std::move(p_routing), p_routing_digest});
+  }
   in_predeliver_[cur_or_next].insert(std::end(in_predeliver_[cur_or_next]),
                                      std::begin(p_predeliver),
                                      std::end(p_predeliver));
@@ -740,26 +801,15 @@ void ClientEnclave::traffic_in(const uint8_t *ptr, size_t len) {
   in_deliver_[cur_or_next].insert(std::begin(p_deliver),
                                   std::end(p_deliver));
 
-  {
-    // remove dummies from routing
-    auto it = std::remove_if(in_routing_[cur_or_next].begin(),
-                             in_routing_[cur_or_next].end(),
-                             [](const std::vector<RoutingSchemeTuple> &routing_vec) {
-                               return routing_vec.empty();
-                             });
-    in_routing_[cur_or_next].erase(it, in_routing_[cur_or_next].end());
-  }
-
   // deliver message
   if (traffic_in_received_from_[cur_or_next].size() > m_corrupt_) {
-    for (auto &message : in_deliver_[cur_or_next]) {
-      if (!message.is_dummy()) {
-        auto &q_in = q_in_for_pseudonyms_.at(decrypt_pseudonym(message.n_dst).get_local_num());
-        if (q_in.find(message) == q_in.last()) {
-          //ocall_print_string("I actually received a message!!!\n");
-          //PRINT_CPP_STRING("Message is: " + message.to_string() + '\n');
-          q_in.push(message);
-        }
+    for (auto &message : in_deliver_[cur_or_next]) { // contains no dummies
+      auto &q_in = q_in_for_pseudonyms_.at(decrypt_pseudonym(message.n_dst).get_local_num());
+      //ocall_print_string("I actually received a message!!!\n");
+      //PRINT_CPP_STRING("Message is: " + message.to_string() + '\n');
+      if (q_in.push(message)) { // ignored if the message is already queued
+        // the untrusted part notifies the subscribers of n_dst once the message is due
+        ocall_message_delivered(message.n_dst.get().data(), message.t_dst);
       }
     }
   }
@@ -767,15 +817,35 @@ void ClientEnclave::traffic_in(const uint8_t *ptr, size_t len) {
   //ocall_print_string("\n");
 }
 
+void ClientEnclave::advance_in_buffers() {
+  in_structure_[0] = std::move(in_structure_[1]);
+  in_structure_[1].clear();
+  in_announce_[0] = std::move(in_announce_[1]);
+  in_announce_[1].clear();
+  in_agreement_[0] = std::move(in_agreement_[1]);
+  in_agreement_[1].clear();
+  in_inject_[0] = std::move(in_inject_[1]);
+  in_inject_[1].clear();
+  in_routing_[0] = std::move(in_routing_[1]);
+  in_routing_[1].clear();
+  in_predeliver_[0] = std::move(in_predeliver_[1]);
+  in_predeliver_[1].clear();
+  in_deliver_[0] = std::move(in_deliver_[1]);
+  in_deliver_[1].clear();
+  traffic_in_received_from_[0] = std::move(traffic_in_received_from_[1]);
+  traffic_in_received_from_[1].clear();
+}
+
 round_t ClientEnclave::get_time() const {
   if (!initialized_) {
     return 0;
   }
 
   auto current_time = TeeFunctions::tee_get_trusted_time();
-  auto time = current_time - init_time_;
-  ASSERT(time >= 0)
-  return time;
+  if (current_time < init_time_) {
+    return 0; // round 0 has not started yet
+  }
+  return static_cast<round_t>(current_time - init_time_);
 }
 
 round_t ClientEnclave::get_t_dst_lower_bound() const {
@@ -784,8 +854,16 @@ round_t ClientEnclave::get_t_dst_lower_bound() const {
   }
 
   return get_time() + (calculate_agreement_time(m_corrupt_)
-      + calculate_routing_time(overlay_dimension_) + 4) * 4 * kDelta;
+      + calculate_routing_time(overlay_dimension_) + 4) * 4 * delta_;
+
+}
+
+int64_t ClientEnclave::get_next_round_time() const {
+  if (!initialized_) {
+    return -1;
+  }
 
+  return static_cast<int64_t>(init_time_) + (cur_round_ + 1) * 4 * delta_;
 }
 
 DecryptedPseudonym ClientEnclave::decrypt_pseudonym(const c1::peer::Pseudonym &pseudonym) const {
@@ -797,24 +875,8 @@ DecryptedPseudonym ClientEnclave::decrypt_pseudonym(const c1::peer::Pseudonym &p
 }
 
 template<typename T>
-std::vector<T> ClientEnclave::obtain_elements_that_exceed_m_corrupt(const std::vector<T> &vec) const {
-  std::map<T, size_t> elems_u_counter;
-  for (const auto &elem_t : vec) {
-    if (elems_u_counter.count(elem_t) == 0) {
-      elems_u_counter[elem_t] = 0;
-    }
-    elems_u_counter[elem_t]++;
-  }
-
-  std::vector<T> result;
-
-  for (const auto &[elem, count] : elems_u_counter) {
-    if (count > m_corrupt_) {
-      result.push_back(elem);
-    }
-  }
-
-  return result;
+std::vector<std::reference_wrapper<const T>> ClientEnclave::obtain_elements_that_exceed_m_corrupt(const std::vector<T> &vec) {
+  return threshold_counter_.exceeding(vec, m_corrupt_);
 }
 
 } // ~namespace
@@ -839,6 +901,10 @@ int ecall_generate_pseudonym(uint8_t pseudonym[kPseudonymSize]) {
   return c1::peer::ClientEnclave::instance().generate_pseudonym(pseudonym);
 }
 
+size_t ecall_generate_pseudonyms(uint8_t *pseudonyms, size_t count) {
+  return c1::peer::ClientEnclave::instance().generate_pseudonyms(pseudonyms, count);
+}
+
 void ecall_send_message(uint8_t n_src[kPseudonymSize],
                         uint8_t msg[kMessageSize],
                         uint8_t n_dst[kPseudonymSize],
@@ -869,6 +935,14 @@ int64_t ecall_get_t_dst_lower_bound() {
   return c1::peer::ClientEnclave::instance().get_t_dst_lower_bound();
 }
 
+int64_t ecall_get_next_round_time() {
+  return c1::peer::ClientEnclave::instance().get_next_round_time();
+}
+
+void ecall_set_visualization(int enabled, uint32_t round_interval, uint32_t peer_modulus) {
+  c1::peer::ClientEnclave::instance().set_visualization(enabled, round_interval, peer_modulus);
+}
+
 #if defined(__cplusplus)
 }
 #endif
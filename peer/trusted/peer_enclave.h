@@ -15,7 +15,9 @@
 #include "../../include/message_structs.h"
 #include "overlay_structure_scheme.h"
 #include "../../include/misc.h"
-#include "../../login_server/trusted/searchable_queue.h"
+#include "structs/message_queue.h"
+#include "structs/message_tuple_set.h"
+#include "threshold_counter.h"
 
 namespace c1::peer {
 
@@ -65,8 +67,10 @@ class ClientEnclave {
  private:
   /** Whether the login server has initiated the whole anonymous system yet */
   bool initialized_ = false;
-  /** Time of initialization */
+  /** Time at which round 0 starts (as given by the login server) */
   tee_time_t init_time_{};
+  /** see paper (in milliseconds, as given by the login server) */
+  int64_t delta_ = kDefaultDelta;
   /** Dimension of the overlay */
   dim_t overlay_dimension_{};
 
@@ -78,12 +82,30 @@ class ClientEnclave {
    */
   void try_and_send_msg_to_server(void *msg_raw, size_t msg_len) const;
 
+  /**
+   * Ask the untrusted part to connect to all peers of the overlay structure scheme (current and upcoming neighbors)
+   * it has not been asked to connect to yet, so that no connection has to be established at a round boundary.
+   */
+  void connect_to_new_peers();
+
+  /**
+   * Move the messages received for the next round (in[1]) to the current round (in[0]) at the end of a round.
+   */
+  void advance_in_buffers();
+
  public:
   /**
    * see paper
    * @param pseudonym
    */
   bool generate_pseudonym(uint8_t *pseudonym);
+  /**
+   * Generate up to count pseudonyms at once (at most kAMax per peer in total).
+   * @param pseudonyms receives the pseudonyms, kPseudonymSize bytes each (room for count of them)
+   * @param count
+   * @return the number of pseudonyms generated
+   */
+  size_t generate_pseudonyms(uint8_t *pseudonyms, size_t count);
   /**
    * see paper
    * @param n_src
@@ -119,7 +141,7 @@ class ClientEnclave {
    */
   void traffic_in(const uint8_t *ptr, size_t len);
   /**
-   * retrieves the current time, relative to the initialization time
+   * retrieves the current time in milliseconds, relative to the start of round 0 (0 before round 0 has started)
    * @return
    */
   [[nodiscard]] round_t get_time() const;
@@ -130,6 +152,24 @@ class ClientEnclave {
    */
   [[nodiscard]] round_t get_t_dst_lower_bound() const;
 
+  /**
+   * retrieves the trusted time stamp at which the next call of traffic_out will be due (i.e., the start of the next
+   * round), so that the untrusted part can sleep until then
+   * @return the time stamp in milliseconds (same reference point as TeeFunctions::tee_get_trusted_time()), -1 if not
+   * initialized yet
+   */
+  [[nodiscard]] int64_t get_next_round_time() const;
+
+  /**
+   * Configure which rounds traffic_out() captures for the visualization (only with BUILD_WITH_VISUALIZATION; nothing
+   * is copied or serialized for the other rounds).
+   * @param enabled whether to capture anything at all
+   * @param round_interval capture every round_interval-th round (0 is treated as 1)
+   * @param peer_modulus capture only if the id of this peer is a multiple of peer_modulus (0 is treated as 1), so that
+   * only a subset of the peers of a large network reports to the visualization
+   */
+  void set_visualization(bool enabled, uint32_t round_interval, uint32_t peer_modulus);
+
  private:
   /** see paper */
   size_t m_corrupt_ = 1;
@@ -150,8 +190,7 @@ class ClientEnclave {
   /** see paper */
   tee_cmac_128bit_key_t sk_routing_{};
   /** set q_in (see paper), one for each (of the local) pseudonym(s) */
-  std::vector<SearchableQueue<MessageTuple, std::vector<MessageTuple>, std::greater<>>>
-      q_in_for_pseudonyms_;
+  std::vector<MessageQueue> q_in_for_pseudonyms_;
   /** see paper */
   std::priority_queue<MessageTuple, std::vector<MessageTuple>, std::greater<>> q_out_;
   /** used to count the messages sent from each of the local pseudonyms for each round (to check if we respected the k_send limit) */
@@ -159,8 +198,9 @@ class ClientEnclave {
       num_q_out_entries_for_round_for_pseudonym_;
   /** see paper (called N there) */
   std::vector<DecryptedPseudonym> pseudonyms_;
-  /** encrypted version (for feasibility checks of user input) */
-  std::vector<std::vector<uint8_t>> pseudonyms_enc_;
+  /** the local number of each pseudonym by its encrypted version as handed out to the user (i.e., truncated to
+   * kPseudonymSize), to check the user input without decrypting it */
+  std::unordered_map<Pseudonym, size_t> local_pseudonyms_;
   /** basically, this is st_overlay */
   OverlayStructureScheme overlay_structure_scheme_;
   /** set in for this tag - twice because we may receive messages for the next round and the round after (due to delay) */
@@ -173,12 +213,11 @@ class ClientEnclave {
   /** set in for this tag - twice because we may receive messages for the next round and the round after (due to delay) */
   std::array<std::vector<MessageTuple>, 2> in_inject_;
   /** set in for this tag - twice because we may receive messages for the next round and the round after (due to delay) */
-  std::array<std::vector<std::vector<RoutingSchemeTuple>>, 2>
-      in_routing_;
+  std::array<std::vector<RoutingBlock>, 2> in_routing_;
   /** set in for this tag - twice because we may receive messages for the next round and the round after (due to delay) */
   std::array<std::vector<MessageTuple>, 2> in_predeliver_;
   /** set in for this tag - twice because we may receive messages for the next round and the round after (due to delay) */
-  std::array<std::set<MessageTuple>, 2> in_deliver_;
+  std::array<MessageTupleSet, 2> in_deliver_;
   /** the tuples to be stored for messages whose agreement protocol this TEE is currently part of */
   std::vector<AgreementLocalTuple> agreement_tuples_;
   /** see paper (called l_now there) */
@@ -188,6 +227,14 @@ class ClientEnclave {
       gamma_agree_for_round_;
   /** Used to ignore messages sent twice (to prevent replay attacks) */
   std::array<std::map<PeerInformation, bool>, 2> traffic_in_received_from_;
+  /** used for the majority votes (kept as a member so that its table is reused between rounds) */
+  ThresholdCounter threshold_counter_;
+  /** the peers the untrusted part has already been asked to connect to (see connect_to_new_peers()) */
+  PeerSet connected_peers_;
+  /** see set_visualization() */
+  bool vis_enabled_ = false;
+  uint32_t vis_round_interval_ = 1;
+  uint32_t vis_peer_modulus_ = 1;
 
   /**
    * Decrypt a pseudonym to obtain the id of the node with that pseudonym and the onid of its associated quorum
@@ -200,10 +247,10 @@ class ClientEnclave {
    * For a given vector v of elements of type T, return those elements that occur more than m_corrupt times in v
    * @tparam T Type of the elements in the vector
    * @param vec The input vector
-   * @return a vector containing only the desired elements (and only once)
+   * @return references to the desired elements in vec (each element only once)
    */
   template<typename T>
-  std::vector<T> obtain_elements_that_exceed_m_corrupt(const std::vector<T> &vec) const;
+  std::vector<std::reference_wrapper<const T>> obtain_elements_that_exceed_m_corrupt(const std::vector<T> &vec);
 
 };
 
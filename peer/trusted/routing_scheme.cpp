@@ -9,18 +9,20 @@
 
 namespace c1::peer {
 
-std::vector<RoutingSchemeTuple> RoutingScheme::route(std::vector<RoutingSchemeTuple> &set_s,
+std::vector<RoutingSchemeTuple> RoutingScheme::route(const std::vector<RoutingSchemeTuple> &set_s,
                                                      round_t cur_round,
                                                      dim_t overlay_dimension,
                                                      const tee_cmac_128bit_key_t &sk_routing) {
-  auto cancel_set = determine_elements_to_be_cancelled(set_s);
+  std::vector<bool> cancelled;
+  auto order = sort_and_determine_elements_to_be_cancelled(set_s, cancelled);
   std::vector<RoutingSchemeTuple> result;
+  result.reserve(set_s.size());
 
-  for (auto &s : set_s) {
-    if (cancel_set.count(RoutingSchemeTuple{MessageTuple::create_cancel(), s.onid_dst,
-                                            s.bucket_dst, s.l_dst, s.onid_current})) {
+  for (auto index : order) {
+    if (cancelled[index]) {
       continue;
     }
+    auto s = set_s[index];
     auto i = 1 + 2 * overlay_dimension - (s.l_dst - cur_round);
     auto onid_itm = cryptlib::get_intermediate_target(sk_routing, s.bucket_dst, s.l_dst, overlay_dimension);
     ocall_print_string(std::string(
@@ -35,43 +37,73 @@ std::vector<RoutingSchemeTuple> RoutingScheme::route(std::vector<RoutingSchemeTu
       s.onid_current ^= (-itm_bit ^ s.onid_current)
           & (1UL << (i - overlay_dimension)); // changes the i-th bit of s.onid_current to itm_bit
     }
-    result.push_back(s);
+    result.push_back(std::move(s));
   }
 
   return result;
 }
 
-std::set<RoutingSchemeTuple> RoutingScheme::determine_elements_to_be_cancelled(std::vector<RoutingSchemeTuple> &set_s) {
-  std::set<RoutingSchemeTuple> result;
+Digest RoutingScheme::group_digest(const RoutingSchemeTuple &s) {
+  std::array<uint8_t, sizeof(s.onid_dst) + kPseudonymSize + sizeof(s.l_dst) + sizeof(s.onid_current)> bytes{};
+  auto ptr = bytes.data();
+  memcpy(ptr, &s.onid_dst, sizeof(s.onid_dst));
+  ptr += sizeof(s.onid_dst);
+  memcpy(ptr, s.bucket_dst.get().data(), kPseudonymSize);
+  ptr += kPseudonymSize;
+  memcpy(ptr, &s.l_dst, sizeof(s.l_dst));
+  ptr += sizeof(s.l_dst);
+  memcpy(ptr, &s.onid_current, sizeof(s.onid_current));
+  return compute_digest(bytes.data(), bytes.size());
+}
+
+bool RoutingScheme::same_group(const RoutingSchemeTuple &lhs, const RoutingSchemeTuple &rhs) {
+  return std::tie(lhs.onid_dst, lhs.bucket_dst, lhs.l_dst, lhs.onid_current)
+      == std::tie(rhs.onid_dst, rhs.bucket_dst, rhs.l_dst, rhs.onid_current);
+}
 
-  if (set_s.empty()) {
-    return result;
+std::vector<uint32_t> RoutingScheme::sort_and_determine_elements_to_be_cancelled(const std::vector<RoutingSchemeTuple> &set_s,
+                                                                                 std::vector<bool> &cancelled) {
+  cancelled.assign(set_s.size(), false);
+  std::vector<uint32_t> order;
+  order.reserve(set_s.size());
+
+  std::vector<SortKey> keys;
+  keys.reserve(set_s.size());
+  for (uint32_t i = 0; i < set_s.size(); ++i) {
+    keys.push_back(SortKey{group_digest(set_s[i]), set_s[i].m.digest(), i});
+  }
+  std::sort(keys.begin(), keys.end());
+  for (const auto &key : keys) {
+    order.push_back(key.index);
   }
 
-  std::sort(set_s.begin(), set_s.end());
-  {
-    auto &prev_element = set_s.at(0);
-    auto prev_element_index = 0;
-    for (size_t i = 0; i < set_s.size(); ++i) {
-      if (set_s[i].m.is_cancel()) {
-        result.emplace(RoutingSchemeTuple{MessageTuple::create_cancel(), prev_element.onid_dst, prev_element.bucket_dst,
-                                          prev_element.l_dst, prev_element.onid_current});
-        ocall_print_string(std::string("Cancelling message!\n").c_str());
-      }
+  // if two different groups share a digest, they may be interleaved, so fall back to sorting the tuples themselves
+  for (size_t i = 1; i < keys.size(); ++i) {
+    if (keys[i].group == keys[i - 1].group && !same_group(set_s[order[i]], set_s[order[i - 1]])) {
+      std::sort(order.begin(), order.end(), [&set_s](uint32_t lhs, uint32_t rhs) { return set_s[lhs] < set_s[rhs]; });
+      break;
+    }
+  }
 
-      if (std::tie(prev_element.onid_dst, prev_element.bucket_dst, prev_element.l_dst, prev_element.onid_current) !=
-          std::tie(set_s[i].onid_dst, set_s[i].bucket_dst, set_s[i].l_dst, set_s[i].onid_current)) {
-        if (i - prev_element_index > kRecv) {
-          result.emplace(RoutingSchemeTuple{MessageTuple::create_cancel(), prev_element.onid_dst,
-                                            prev_element.bucket_dst, prev_element.l_dst, prev_element.onid_current});
-        }
-        prev_element = set_s.at(i);
-        prev_element_index = i;
+  // one pass over the groups: a group is cancelled if it contains M_cancel or exceeds k_recv
+  size_t group_begin = 0;
+  while (group_begin < order.size()) {
+    size_t group_end = group_begin + 1;
+    bool contains_cancel = set_s[order[group_begin]].m.is_cancel();
+    while (group_end < order.size() && same_group(set_s[order[group_begin]], set_s[order[group_end]])) {
+      contains_cancel = contains_cancel || set_s[order[group_end]].m.is_cancel();
+      group_end++;
+    }
+    if (contains_cancel || group_end - group_begin > kRecv) {
+      ocall_print_string(std::string("Cancelling message!\n").c_str());
+      for (size_t i = group_begin; i < group_end; ++i) {
+        cancelled[order[i]] = true;
       }
     }
+    group_begin = group_end;
   }
 
-  return result;
+  return order;
 }
 
 } // !namespace
@@ -25,17 +25,51 @@ class RoutingScheme {
    * @param sk_routing
    * @return
    */
-  static std::vector<RoutingSchemeTuple> route(std::vector<RoutingSchemeTuple> &set_s,
+  static std::vector<RoutingSchemeTuple> route(const std::vector<RoutingSchemeTuple> &set_s,
                                                round_t cur_round,
                                                dim_t overlay_dimension,
                                                const tee_cmac_128bit_key_t &sk_routing
   );
 
  private:
-  /** determine all messages that have to be cancelled in the current call of route()
-   *  (messages that exceed k_receive for one target bucket are dropped and replaced by M_cancel, see paper)
+  /**
+   * Sort key of a tuple in set_s. Sorting these keys (instead of the tuples themselves) groups the tuples by
+   * (onid_dst, bucket_dst, l_dst, onid_current) in an order that is the same for all members of a quorum.
+   */
+  struct SortKey {
+    /** digest of (onid_dst, bucket_dst, l_dst, onid_current) */
+    Digest group;
+    /** digest of the message */
+    Digest message;
+    /** index of the tuple in set_s */
+    uint32_t index;
+
+    bool operator<(const SortKey &rhs) const {
+      return std::tie(group, message) < std::tie(rhs.group, rhs.message);
+    }
+  };
+
+  /**
+   * Compute the digest of (onid_dst, bucket_dst, l_dst, onid_current) of a tuple.
+   * @param s
+   * @return
+   */
+  static Digest group_digest(const RoutingSchemeTuple &s);
+
+  /**
+   * Check whether two tuples belong to the same group (i.e., have the same onid_dst, bucket_dst, l_dst, onid_current).
+   */
+  static bool same_group(const RoutingSchemeTuple &lhs, const RoutingSchemeTuple &rhs);
+
+  /**
+   * Sort (the indices of) set_s by group and determine all messages that have to be cancelled in the current call of
+   * route() (messages that exceed k_receive for one target bucket are dropped and replaced by M_cancel, see paper).
+   * @param set_s
+   * @param cancelled set to true for each index in set_s whose tuple is cancelled
+   * @return the indices of set_s in sorted order
    */
-  static std::set<RoutingSchemeTuple> determine_elements_to_be_cancelled(std::vector<RoutingSchemeTuple> &set_s);
+  static std::vector<uint32_t> sort_and_determine_elements_to_be_cancelled(const std::vector<RoutingSchemeTuple> &set_s,
+                                                                           std::vector<bool> &cancelled);
 };
 
 } // !namespace
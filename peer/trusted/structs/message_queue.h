@@ -0,0 +1,75 @@
+/**
+ * Priority queue of received MessageTuples (the set q_in of the paper).
+ */
+
+#ifndef MESSAGE_QUEUE_H
+#define MESSAGE_QUEUE_H
+
+#include <queue>
+#include <unordered_set>
+#include <vector>
+#include "../../../include/misc.h"
+
+namespace c1::peer {
+
+/**
+ * Min-heap of MessageTuples ordered by t_dst, indexed by a hash set so that checking whether a message is already
+ * queued takes constant time (instead of scanning the whole heap).
+ * The set owns the tuples, the heap only holds pointers to them (the set never moves its elements).
+ */
+class MessageQueue {
+  struct LaterDelivery {
+    bool operator()(const MessageTuple *lhs, const MessageTuple *rhs) const {
+      // break ties by digest so that the order does not depend on the order of insertion
+      return std::tie(lhs->t_dst, lhs->digest()) > std::tie(rhs->t_dst, rhs->digest());
+    }
+  };
+
+  std::unordered_set<MessageTuple> messages_;
+  std::priority_queue<const MessageTuple *, std::vector<const MessageTuple *>, LaterDelivery> heap_;
+
+ public:
+  MessageQueue() = default;
+  // copying would leave the heap pointing into the set of the original queue (moving keeps the set's nodes)
+  MessageQueue(const MessageQueue &) = delete;
+  MessageQueue &operator=(const MessageQueue &) = delete;
+  MessageQueue(MessageQueue &&) = default;
+  MessageQueue &operator=(MessageQueue &&) = default;
+
+  /**
+   * Add a message to the queue unless it is already queued.
+   * @param message
+   * @return true iff the message was added
+   */
+  bool push(const MessageTuple &message) {
+    auto[it, inserted] = messages_.insert(message);
+    if (inserted) {
+      heap_.push(&*it);
+    }
+    return inserted;
+  }
+
+  bool contains(const MessageTuple &message) const {
+    return messages_.count(message) != 0;
+  }
+
+  /**
+   * @return the message with the lowest t_dst (the queue must not be empty)
+   */
+  const MessageTuple &top() const {
+    return *heap_.top();
+  }
+
+  void pop() {
+    auto top = heap_.top();
+    heap_.pop();
+    messages_.erase(*top);
+  }
+
+  size_t size() const { return heap_.size(); }
+  bool empty() const { return heap_.empty(); }
+};
+
+} // !namespace
+
+#endif //MESSAGE_QUEUE_H
@@ -0,0 +1,54 @@
+/**
+ * A hash-based set of MessageTuples.
+ */
+
+#ifndef MESSAGE_TUPLE_SET_H
+#define MESSAGE_TUPLE_SET_H
+
+#include <iterator>
+#include <unordered_set>
+#include "../../../include/misc.h"
+
+namespace c1::peer {
+
+/**
+ * Set of MessageTuples that identifies tuples by their full content (as opposed to std::set<MessageTuple>, whose
+ * ordering only considers t_dst and thus collapses distinct messages with the same delivery time).
+ * Lookups are keyed on the digest of the tuples.
+ */
+class MessageTupleSet {
+  std::unordered_set<MessageTuple> set_;
+
+ public:
+  typedef std::unordered_set<MessageTuple>::const_iterator const_iterator;
+
+  /**
+   * Insert all non-dummy tuples in [first, last) (dummies carry no message and are thus never stored).
+   * @tparam InputIt
+   * @param first
+   * @param last
+   */
+  template<typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    set_.reserve(set_.size() + static_cast<size_t>(std::distance(first, last)));
+    for (; first != last; ++first) {
+      if (!first->is_dummy()) {
+        set_.insert(*first);
+      }
+    }
+  }
+
+  bool contains(const MessageTuple &message) const {
+    return set_.count(message) != 0;
+  }
+
+  const_iterator begin() const { return set_.cbegin(); }
+  const_iterator end() const { return set_.cend(); }
+  size_t size() const { return set_.size(); }
+  bool empty() const { return set_.empty(); }
+  void clear() { set_.clear(); }
+};
+
+} // !namespace
+
+#endif //MESSAGE_TUPLE_SET_H
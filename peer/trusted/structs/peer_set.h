@@ -0,0 +1,80 @@
+/**
+ * A set of peers with constant-time membership tests.
+ */
+
+#ifndef PEER_SET_H
+#define PEER_SET_H
+
+#include <cassert>
+#include <vector>
+#include "../../../include/config.h"
+#include "../../../include/message_structs.h"
+
+namespace c1::peer {
+
+/**
+ * Set of peers that keeps the order of insertion (like the vectors it replaces). Membership is tracked in a bitmap
+ * indexed by the peer ids (which the login server assigns densely, starting at 0), so inserting a peer only takes
+ * constant time and merging two sets takes linear time.
+ */
+class PeerSet {
+  std::vector<PeerInformation> peers_;
+  std::vector<bool> members_;
+
+ public:
+  typedef std::vector<PeerInformation>::const_iterator const_iterator;
+
+  PeerSet() = default;
+
+  explicit PeerSet(const std::vector<PeerInformation> &peers) {
+    insert(peers.begin(), peers.end());
+  }
+
+  /**
+   * Add a peer unless it is already contained.
+   * @param peer
+   * @return true iff the peer was added
+   */
+  bool insert(const PeerInformation &peer) {
+    assert(peer.id >= 0);
+    auto index = static_cast<size_t>(peer.id);
+    if (index >= members_.size()) {
+      members_.resize(index + 1);
+    }
+    if (members_[index]) {
+      return false;
+    }
+    members_[index] = true;
+    peers_.push_back(peer);
+    return true;
+  }
+
+  template<typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      insert(*first);
+    }
+  }
+
+  bool contains(peer_id_t id) const {
+    return id >= 0 && static_cast<size_t>(id) < members_.size() && members_[static_cast<size_t>(id)];
+  }
+
+  void clear() {
+    for (const auto &peer : peers_) {
+      members_[static_cast<size_t>(peer.id)] = false;
+    }
+    peers_.clear();
+  }
+
+  /** the peers in the order of their insertion */
+  const std::vector<PeerInformation> &peers() const { return peers_; }
+  const_iterator begin() const { return peers_.cbegin(); }
+  const_iterator end() const { return peers_.cend(); }
+  size_t size() const { return peers_.size(); }
+  bool empty() const { return peers_.empty(); }
+};
+
+} // !namespace
+
+#endif //PEER_SET_H
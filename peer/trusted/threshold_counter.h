@@ -0,0 +1,106 @@
+/**
+ * Author: Alexander S.
+ * Counter used for the majority votes of the peer (see obtain_elements_that_exceed_m_corrupt()).
+ */
+
+#ifndef THRESHOLD_COUNTER_H
+#define THRESHOLD_COUNTER_H
+
+#include <functional>
+#include <vector>
+#include "../../include/digest.h"
+
+namespace c1::peer {
+
+/**
+ * Determines the elements of a vector that occur more than a given number of times.
+ * Elements are counted in a flat (open addressing) hash table keyed by their digest (elements have to provide a
+ * digest() method). Elements with equal digests are additionally compared with operator== so that the result is exact.
+ * The table keeps its capacity between calls, so that it can be reused every round without reallocating.
+ */
+class ThresholdCounter {
+  struct Slot {
+    Digest digest;
+    /** index (in the input vector) of the first occurrence of this element, npos if the slot is empty */
+    size_t first = npos;
+    size_t count = 0;
+  };
+
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  std::vector<Slot> slots_;
+  /** indices of the used slots in the order of their first use */
+  std::vector<size_t> used_;
+
+ public:
+  /**
+   * Return the elements of vec (each once, in the order of their first occurrence) that occur more than threshold times.
+   * @tparam T type of the elements
+   * @param vec
+   * @param threshold
+   * @return references to the elements in vec
+   */
+  template<typename T>
+  std::vector<std::reference_wrapper<const T>> exceeding(const std::vector<T> &vec, size_t threshold) {
+    std::vector<std::reference_wrapper<const T>> result;
+    if (vec.empty()) {
+      return result;
+    }
+    reserve(vec.size());
+
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = 0; i < vec.size(); ++i) {
+      const auto &digest = vec[i].digest();
+      for (size_t pos = std::hash<Digest>{}(digest) & mask;; pos = (pos + 1) & mask) {
+        auto &slot = slots_[pos];
+        if (slot.first == npos) {
+          slot.digest = digest;
+          slot.first = i;
+          slot.count = 1;
+          used_.push_back(pos);
+          break;
+        }
+        if (slot.digest == digest && vec[slot.first] == vec[i]) {
+          slot.count++;
+          break;
+        }
+      }
+    }
+
+    for (auto pos : used_) {
+      if (slots_[pos].count > threshold) {
+        result.emplace_back(vec[slots_[pos].first]);
+      }
+    }
+    clear();
+    return result;
+  }
+
+ private:
+  /**
+   * Make sure that the table holds at least twice as many slots as there are elements to be counted.
+   * @param num_elements
+   */
+  void reserve(size_t num_elements) {
+    size_t capacity = slots_.empty() ? 16 : slots_.size();
+    while (capacity < 2 * num_elements) {
+      capacity *= 2;
+    }
+    if (capacity != slots_.size()) {
+      slots_.assign(capacity, Slot{});
+    }
+    used_.reserve(num_elements);
+  }
+
+  /** reset all used slots (cheaper than resetting the whole table) */
+  void clear() {
+    for (auto pos : used_) {
+      slots_[pos] = Slot{};
+    }
+    used_.clear();
+  }
+};
+
+} // !namespace
+
+#endif //THRESHOLD_COUNTER_H
@@ -15,12 +15,15 @@ void ecall_init();
 void ecall_network_init(uint8_t ip1, uint8_t ip2, uint8_t ip3, uint8_t ip4, uint64_t port);
 void ecall_received_msg_from_server(const uint8_t *ptr, size_t len);
 int ecall_generate_pseudonym(uint8_t pseudonym[8]);
+size_t ecall_generate_pseudonyms(uint8_t *pseudonyms, size_t count);
 void ecall_send_message(uint8_t n_src[8], uint8_t msg[4], uint8_t n_dst[8], int64_t t_dst);
 int ecall_receive_message(uint8_t n_dst[8], uint8_t msg[4], uint8_t n_src[8], int64_t *t_dst);
 int ecall_traffic_out();
 void ecall_traffic_in(const uint8_t *ptr, size_t len);
 int64_t ecall_get_time();
 int64_t ecall_get_t_dst_lower_bound();
+int64_t ecall_get_next_round_time();
+void ecall_set_visualization(int enabled, uint32_t round_interval, uint32_t peer_modulus);
 
 #ifdef __cplusplus
 }
@@ -47,6 +50,10 @@ tee_status_t ecall_generate_pseudonym(tee_enclave_id_t eid, int *retval, uint8_t
   *retval = ecall_generate_pseudonym(pseudonym);
 }
 
+tee_status_t ecall_generate_pseudonyms(tee_enclave_id_t eid, size_t *retval, uint8_t *pseudonyms, size_t count) {
+  *retval = ecall_generate_pseudonyms(pseudonyms, count);
+}
+
 tee_status_t ecall_send_message(tee_enclave_id_t eid,
                                 uint8_t n_src[8],
                                 uint8_t msg[4],
@@ -79,3 +86,11 @@ tee_status_t ecall_get_time(tee_enclave_id_t eid, int64_t *retval) {
 tee_status_t ecall_get_t_dst_lower_bound(tee_enclave_id_t eid, int64_t *retval) {
   *retval = ecall_get_t_dst_lower_bound();
 }
+
+tee_status_t ecall_get_next_round_time(tee_enclave_id_t eid, int64_t *retval) {
+  *retval = ecall_get_next_round_time();
+}
+
+tee_status_t ecall_set_visualization(tee_enclave_id_t eid, int enabled, uint32_t round_interval, uint32_t peer_modulus) {
+  ecall_set_visualization(enabled, round_interval, peer_modulus);
+}
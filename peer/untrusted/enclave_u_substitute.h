@@ -19,6 +19,7 @@ tee_status_t ecall_network_init(tee_enclave_id_t eid,
                                 uint64_t port);
 tee_status_t ecall_received_msg_from_server(tee_enclave_id_t eid, const uint8_t *ptr, size_t len);
 tee_status_t ecall_generate_pseudonym(tee_enclave_id_t eid, int *retval, uint8_t pseudonym[8]);
+tee_status_t ecall_generate_pseudonyms(tee_enclave_id_t eid, size_t *retval, uint8_t *pseudonyms, size_t count);
 tee_status_t ecall_send_message(tee_enclave_id_t eid,
                                 uint8_t n_src[8],
                                 uint8_t msg[4],
@@ -34,5 +35,7 @@ tee_status_t ecall_traffic_out(tee_enclave_id_t eid, int *retval);
 tee_status_t ecall_traffic_in(tee_enclave_id_t eid, const uint8_t *ptr, size_t len);
 tee_status_t ecall_get_time(tee_enclave_id_t eid, int64_t *retval);
 tee_status_t ecall_get_t_dst_lower_bound(tee_enclave_id_t eid, int64_t *retval);
+tee_status_t ecall_get_next_round_time(tee_enclave_id_t eid, int64_t *retval);
+tee_status_t ecall_set_visualization(tee_enclave_id_t eid, int enabled, uint32_t round_interval, uint32_t peer_modulus);
 
 #endif //PEER_ENCLAVE_U_SUBSTITUTE_H
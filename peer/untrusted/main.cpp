@@ -18,15 +18,42 @@ int main(int argc, char *argv[]) {
   std::string id_visualization = "-1";
   std::string port_in = "*";
   std::string interface_port_in = "*";
+  std::string notify_port_in = "*";
+  int io_threads = 1;
+  bool no_shm = false;
+  bool use_udp = false;
+  size_t pseudonym_pool = 0;
+  size_t max_frame_size = kDefaultMaxFrameSize;
+  uint32_t vis_round_interval = 1;
+  uint32_t vis_peer_modulus = 1;
   app.add_option("-p,--port-login-server", port_login_server, "Port of login server");
   app.add_option("-l,--ip-login-server", ip_login_server, "Ip of login server");
   app.add_option("-o,--ip-self", ip_self, "Own ip");
   app.add_option("-v,--ip-visualization", ip_visualization, "Visualization ip");
+  app.add_option("--vis-rounds",
+                 vis_round_interval,
+                 "Report only every n-th round to the visualization");
+  app.add_option("--vis-peers",
+                 vis_peer_modulus,
+                 "Report to the visualization only if the id of this peer is a multiple of this number");
   app.add_option("-s,--vis-id", id_visualization, "Own self given id (for the visualization)");
   app.add_option("-i,--port-in", port_in, "In port (for login server and peers) that this peer is listening on");
   app.add_option("-c,--port-interface-in",
                  interface_port_in,
                  "In port (for the client interface) that this peer is listening on");
+  app.add_option("--port-notify",
+                 notify_port_in,
+                 "Port of the socket publishing the delivered messages (for the client interface)");
+  app.add_option("--io-threads", io_threads, "Number of ZeroMQ I/O threads");
+  app.add_flag("--no-shm", no_shm, "Do not use shared memory for peers on the same host (always use TCP)");
+  app.add_flag("--udp", use_udp, "Send to other peers via UDP instead of TCP (all peers have to use this option)");
+  app.add_option("--pseudonym-pool",
+                 pseudonym_pool,
+                 "Number of pseudonyms generated in advance for the client interface (at most kAMax in total)");
+  app.add_option("--max-frame-size",
+                 max_frame_size,
+                 "Largest frame (in bytes) sent to another peer via shared memory or UDP, larger ones use TCP (has to be "
+                 "the same for all peers)");
   CLI11_PARSE(app, argc, argv)
 
   std::regex pat{R"(\d{1,3}\.\d{1,3}\.\d{1,3}\.\d{1,3})"};
@@ -35,14 +62,22 @@ int main(int argc, char *argv[]) {
     return 0;
   }
 
+  if (io_threads < 1) {
+    std::cout << "Error: there has to be at least one I/O thread" << std::endl;
+    return 1;
+  }
+
   if (!ip_visualization.empty()) {
     Client::instance().set_vis_ip(ip_visualization);
+    Client::instance().set_vis_sampling(vis_round_interval, vis_peer_modulus);
   }
 
+  Client::instance().set_pseudonym_pool_size(pseudonym_pool);
+  Client::instance().set_max_frame_size(max_frame_size);
   Client::instance().initialize_network_manager(port_login_server,
                                                 ip_login_server,
                                                 ip_self,
                                                 id_visualization,
-                                                port_in, interface_port_in);
+                                                port_in, interface_port_in, notify_port_in, io_threads, !no_shm, use_udp);
   return Client::instance().run();
 }
\ No newline at end of file
@@ -11,14 +11,26 @@
 
 namespace c1::peer {
 
-static constexpr auto HEARTBEAT_INTERVAL = 500;
-
-network_manager::network_manager() : context_{1}, server_socket_out_{context_, ZMQ_DEALER},
-                                     server_and_peer_socket_in_{context_, ZMQ_DEALER},
-                                     user_socket_{context_, ZMQ_REP},
+/** how long the network threads block in zmq::poll before checking whether they have been stopped (in ms) */
+static constexpr auto POLL_INTERVAL = 100;
+/** maximum number of received messages handed to the enclave per MainLoop() (so traffic_out is not delayed) */
+static constexpr size_t MAX_MESSAGES_PER_LOOP = 256;
+static constexpr size_t NETWORK_QUEUE_CAPACITY = 4096;
+static constexpr size_t USER_QUEUE_CAPACITY = 1024;
+/** maximum number of user requests handled per MainLoop() (a batch command counts as one) */
+static constexpr size_t MAX_USER_REQUESTS_PER_LOOP = 64;
+
+network_manager::network_manager() : context_{}, server_socket_out_{}, server_and_peer_socket_in_{}, user_socket_{},
+                                     notify_socket_{},
                                      global_sgx_eid_{0},
-                                     pollitems_{{static_cast<void *>(server_and_peer_socket_in_), 0, ZMQ_POLLIN, 0}},
-                                     pollitems_user_{{static_cast<void *>(user_socket_), 0, ZMQ_POLLIN, 0}} {
+                                     incoming_{NETWORK_QUEUE_CAPACITY},
+                                     incoming_shm_{NETWORK_QUEUE_CAPACITY},
+                                     incoming_udp_{NETWORK_QUEUE_CAPACITY},
+                                     outgoing_{NETWORK_QUEUE_CAPACITY},
+                                     user_requests_{USER_QUEUE_CAPACITY},
+                                     user_replies_{USER_QUEUE_CAPACITY},
+                                     user_events_{USER_QUEUE_CAPACITY},
+                                     zmq_transport_{context_} {
 }
 
 int network_manager::get_port_from_uri(const std::string &uri_str) {
@@ -42,151 +54,450 @@ std::array<uint8_t, 4> network_manager::get_ipv4_from_uri(const std::string &uri
 bool network_manager::MainLoop() {
 
   if (!initialized_url_) {
-    initialize(5671, "localhost", "127.0.0.1", "0", "*", "*");
+    initialize(5671, "localhost", "127.0.0.1", "0", "*", "*", "*");
   }
 
-  zmq::poll(&pollitems_[0], 1, HEARTBEAT_INTERVAL);
-
-  // check in_socket
-  if (pollitems_[0].revents & ZMQ_POLLIN) {
-    //std::cout << "(UNTRUSTED) Received message..." << std::endl;
-    // receive message
-    zmq::message_t msg_content;
-    bool rc = server_and_peer_socket_in_.recv(&msg_content);
-    assert(rc);
-    assert(!msg_content.more());
-
-//    std::cout << "U: " << (rc ? "":"un") << "successfully received message of size " << msg_content.size() << " with first byte: " << std::to_string(*static_cast<uint8_t *>(msg_content.data())) << "...\n";
-
+  bool busy = false;
+  zmq::message_t msg_content;
+  for (size_t i = 0; i < MAX_MESSAGES_PER_LOOP && incoming_.try_pop(msg_content); ++i) {
+    busy = true;
     if (!initialized_) { // message was sent from login_server
-      std::this_thread::sleep_for(std::chrono::milliseconds(1000));
       ecall_received_msg_from_server(global_sgx_eid_, static_cast<uint8_t *>(msg_content.data()), msg_content.size());
       initialized_ = true;
-      /*std::cout << "Initialized everything..." << std::endl;
-      std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-      std::cout << "Waited long enough..." << std::endl;*/
     } else { // message was sent from other peer
-      //std::cout << "calling traffic_in ..." << std::endl;
-      //std::cout << "Received message of length " << msg_content.size() << std::endl;
-      //std::cout << "\trc: " << rc << std::endl;
       ecall_traffic_in(global_sgx_eid_, static_cast<uint8_t *>(msg_content.data()), msg_content.size());
-      //std::cout << "(untrusted) traffic_in call finished..." << std::endl;
-    }
-  }
-
-  // check user socket
-  zmq::poll(&pollitems_user_[0], 1, 0);
-  if (pollitems_user_[0].revents & ZMQ_POLLIN) {
-    // received message from user
-    zmq::message_t msg_content;
-    bool rc0 = user_socket_.recv(&msg_content);
-    assert(rc0);
-    assert(!msg_content.more());
-    //assert(msg_content.size() == 1);
-    char message_type = *static_cast<char *>(msg_content.data());
-    switch (message_type) {
-      case 0: { // generate pseudonym
-        assert(msg_content.size() == 1);
-        std::array<uint8_t, kPseudonymSize> pseud{};
-        int pseudonym_generation_success;
-        ecall_generate_pseudonym(global_sgx_eid_, &pseudonym_generation_success, pseud.data());
-        pseudonyms.push_back(pseud);
-
-        std::string gen_pseud;
-        for (int i = 0; i < pseud.size(); ++i) {
-          gen_pseud += std::to_string(pseud[i]) + (i == pseud.size() - 1 ? "" : " ");
-        }
+    }
+  }
+  // (only peers send via shared memory or UDP, and they do so only after the system has been initialized)
+  for (auto *queue : {&incoming_shm_, &incoming_udp_}) {
+    for (size_t i = 0; initialized_ && i < MAX_MESSAGES_PER_LOOP && queue->try_pop(msg_content); ++i) {
+      busy = true;
+      ecall_traffic_in(global_sgx_eid_, static_cast<uint8_t *>(msg_content.data()), msg_content.size());
+    }
+  }
 
-        std::cout << "Pseudonym is: " << gen_pseud << std::endl << std::endl;
+  UserRequest request;
+  for (size_t i = 0; i < MAX_USER_REQUESTS_PER_LOOP && user_requests_.try_pop(request); ++i) {
+    busy = true;
+    request.payload = handle_user_request(request.payload);
+    if (!push_waiting(user_replies_, request)) {
+      break;
+    }
+    user_doorbell_.ring();
+  }
 
-        // send pseudonym to the user interface
-        zmq::message_t message(gen_pseud.length());
-        memcpy(message.data(), gen_pseud.c_str(), gen_pseud.length());
-        bool rc = user_socket_.send(message);
-        if (!rc) { return -1; }
+  // refill the pool after the requests, so it does not delay them
+  if (initialized_ && !pseudonyms_exhausted_ && pseudonym_pool_.size() < pseudonym_pool_size_) {
+    for (auto &pseudonym : generate_pseudonyms(pseudonym_pool_size_ - pseudonym_pool_.size())) {
+      pseudonym_pool_.push_back(pseudonym);
+    }
+  }
 
-        break;
+  // MainLoop() is called at least once per round, so the events are published within a round after t_dst
+  if (!pending_deliveries_.empty()) {
+    int64_t time;
+    ecall_get_time(global_sgx_eid_, &time);
+    bool published = false;
+    for (; !pending_deliveries_.empty() && pending_deliveries_.top().first <= time; pending_deliveries_.pop()) {
+      const auto &[t_dst, n_dst] = pending_deliveries_.top();
+      zmq::message_t event(kPseudonymSize + sizeof(t_dst));
+      memcpy(event.data(), n_dst.data(), kPseudonymSize);
+      memcpy(static_cast<char *>(event.data()) + kPseudonymSize, &t_dst, sizeof(t_dst));
+      // like the PUB socket, drop the event rather than delaying the enclave thread
+      published |= user_events_.try_push(event);
+    }
+    if (published) {
+      user_doorbell_.ring();
+    }
+  }
+
+  return busy;
+}
+
+void network_manager::message_delivered(const uint8_t *n_dst, round_t t_dst) {
+  std::array<uint8_t, kPseudonymSize> pseudonym{};
+  std::copy(n_dst, n_dst + kPseudonymSize, pseudonym.begin());
+  pending_deliveries_.emplace(t_dst, pseudonym);
+}
+
+zmq::message_t network_manager::handle_user_request(const zmq::message_t &msg_content) {
+  if (msg_content.size() == 0) {
+    return zmq::message_t(0);
+  }
+  char message_type = *static_cast<const char *>(msg_content.data());
+  switch (message_type) {
+    case 0: { // generate pseudonym
+      assert(msg_content.size() == 1);
+      auto taken = take_pseudonyms(1);
+      std::array<uint8_t, kPseudonymSize> pseud{};
+      if (!taken.empty()) {
+        pseud = taken.front();
       }
-      case 1: { // send message
-        auto injection =
-            *reinterpret_cast<UserInterfaceMessageInjectionCommand *>(static_cast<char *>(msg_content.data()) + 1);
-        ecall_send_message(global_sgx_eid_, injection.n_src, injection.msg, injection.n_dst, injection.t_dst);
-        std::cout << "Msg text is: " << injection.msg << std::endl;
-        zmq::message_t message(0);
-        bool rc = user_socket_.send(message);
-        if (!rc) { return -1; }
 
-        break;
+      std::string gen_pseud;
+      for (int i = 0; i < pseud.size(); ++i) {
+        gen_pseud += std::to_string(pseud[i]) + (i == pseud.size() - 1 ? "" : " ");
       }
-      case 2: { // receive message
-        auto injection =
-            *reinterpret_cast<UserInterfaceMessageInjectionCommand *>(static_cast<char *>(msg_content.data()) + 1);
-        int res;
-        ecall_receive_message(global_sgx_eid_, &res, injection.n_dst, injection.msg, injection.n_src, &injection.t_dst);
-        if (!res) {
-          std::cout << "No message ready!\n";
-          const char *msg = "There is no message ready yet!";
-          std::copy(msg, msg + kMessageSize, injection.msg);
-        } else {
-          char msg[kMessageSize];
-          std::copy(injection.msg, injection.msg + kMessageSize, msg);
-          std::cout << "Received message: " << msg << '\n';
+
+      std::cout << "Pseudonym is: " << gen_pseud << std::endl << std::endl;
+
+      // send pseudonym to the user interface
+      return zmq::message_t(gen_pseud.c_str(), gen_pseud.length());
+    }
+    case 1: { // send message
+      auto injection =
+          *reinterpret_cast<const UserInterfaceMessageInjectionCommand *>(static_cast<const char *>(msg_content.data())
+              + 1);
+      ecall_send_message(global_sgx_eid_, injection.n_src, injection.msg, injection.n_dst, injection.t_dst);
+      std::cout << "Msg text is: " << injection.msg << std::endl;
+      return zmq::message_t(0);
+    }
+    case 2: { // receive message
+      auto injection =
+          *reinterpret_cast<const UserInterfaceMessageInjectionCommand *>(static_cast<const char *>(msg_content.data())
+              + 1);
+      int res;
+      ecall_receive_message(global_sgx_eid_, &res, injection.n_dst, injection.msg, injection.n_src, &injection.t_dst);
+      if (!res) {
+        std::cout << "No message ready!\n";
+        const char *msg = "There is no message ready yet!";
+        std::copy(msg, msg + kMessageSize, injection.msg);
+      } else {
+        char msg[kMessageSize];
+        std::copy(injection.msg, injection.msg + kMessageSize, msg);
+        std::cout << "Received message: " << msg << '\n';
+      }
+      return zmq::message_t(reinterpret_cast<char *>(&injection), sizeof(injection));
+    }
+    case 3: {  // get t_dst lower bound
+      int64_t time[2];
+      ecall_get_time(global_sgx_eid_, &time[0]);
+      ecall_get_t_dst_lower_bound(global_sgx_eid_, &time[1]);
+      return zmq::message_t(&time[0], 2 * sizeof(int64_t));
+    }
+    case 4: { // retrieve all pseudonyms
+      int pseudonym_size = kPseudonymSize * sizeof(decltype(pseudonyms)::value_type::value_type);
+
+      zmq::message_t message(pseudonyms.size() * pseudonym_size);
+      auto msg_data_ptr = static_cast<char *>(message.data());
+      for (int i = 0; i < pseudonyms.size(); ++i) {
+        memcpy(msg_data_ptr + i * pseudonym_size, &pseudonyms[i], pseudonym_size);
+      }
+      return message;
+    }
+    case 5: { // retrieve last pseudonym
+      std::string gen_pseud;
+      for (int i = 0; i < kPseudonymSize; i++) {
+        gen_pseud += std::to_string(pseudonyms[pseudonyms.size() - 1][i]) + " ";
+      }
+      std::cout << gen_pseud << std::endl;
+      return zmq::message_t(gen_pseud.c_str(), gen_pseud.length());
+    }
+    case 6: { // get connection statistics
+      auto statistics = get_connection_statistics();
+      return zmq::message_t(&statistics, sizeof(statistics));
+    }
+    case 7: { // send messages
+      uint32_t count = 0;
+      if (msg_content.size() >= 1 + sizeof(count)) {
+        memcpy(&count, static_cast<const char *>(msg_content.data()) + 1, sizeof(count));
+      }
+      if (msg_content.size() != 1 + sizeof(count) + count * sizeof(UserInterfaceMessageInjectionCommand)) {
+        std::cerr << "Malformed batch of messages to send (" << msg_content.size() << " bytes)" << std::endl;
+        count = 0;
+      }
+      auto injections = static_cast<const char *>(msg_content.data()) + 1 + sizeof(count);
+      for (uint32_t i = 0; i < count; ++i) {
+        UserInterfaceMessageInjectionCommand injection{};
+        memcpy(&injection, injections + i * sizeof(injection), sizeof(injection));
+        ecall_send_message(global_sgx_eid_, injection.n_src, injection.msg, injection.n_dst, injection.t_dst);
+      }
+      return zmq::message_t(&count, sizeof(count));
+    }
+    case 8: { // generate pseudonyms
+      uint32_t count = 0;
+      if (msg_content.size() == 1 + sizeof(count)) {
+        memcpy(&count, static_cast<const char *>(msg_content.data()) + 1, sizeof(count));
+      }
+      auto taken = take_pseudonyms(count);
+      zmq::message_t message(taken.size() * kPseudonymSize);
+      if (!taken.empty()) {
+        memcpy(message.data(), taken.data(), taken.size() * kPseudonymSize);
+      }
+      return message;
+    }
+    case 9: { // receive all ready messages
+      uint32_t count = 0;
+      if (msg_content.size() >= 1 + sizeof(count)) {
+        memcpy(&count, static_cast<const char *>(msg_content.data()) + 1, sizeof(count));
+      }
+      if (msg_content.size() != 1 + sizeof(count) + count * kPseudonymSize) {
+        std::cerr << "Malformed list of pseudonyms to receive for (" << msg_content.size() << " bytes)" << std::endl;
+        return zmq::message_t(0);
+      }
+      std::vector<std::array<uint8_t, kPseudonymSize>> receivers(count);
+      for (uint32_t i = 0; i < count; ++i) {
+        memcpy(receivers[i].data(),
+               static_cast<const char *>(msg_content.data()) + 1 + sizeof(count) + i * kPseudonymSize,
+               kPseudonymSize);
+      }
+      const auto &n_dsts = count == 0 ? pseudonyms : receivers;
+
+      std::vector<UserInterfaceMessageInjectionCommand> received;
+      for (const auto &n_dst : n_dsts) {
+        UserInterfaceMessageInjectionCommand injection{};
+        std::copy(n_dst.begin(), n_dst.end(), injection.n_dst);
+        // the enclave hands out one message per call, the ready ones of n_dst have been taken once it fails
+        while (true) {
+          int res = 0;
+          ecall_receive_message(global_sgx_eid_, &res, injection.n_dst, injection.msg, injection.n_src, &injection.t_dst);
+          if (!res) {
+            break;
+          }
+          received.push_back(injection);
         }
-        zmq::message_t message(sizeof(injection));
-        memcpy(message.data(), reinterpret_cast<char *>(&injection), sizeof(injection));
-        bool rc = user_socket_.send(message);
-        if (!rc) { return -1; }
-        break;
       }
-      case 3: {  // get t_dst lower bound
-        int64_t time[2];
-        ecall_get_time(global_sgx_eid_, &time[0]);
-        ecall_get_t_dst_lower_bound(global_sgx_eid_, &time[1]);
-        //std::cout << "Time: " <<  time << '\n';
-
-        zmq::message_t message(2 * sizeof(int64_t));
-        memcpy(message.data(), &time[0], 2 * sizeof(int64_t));
-        bool rc = user_socket_.send(message);
-        if (!rc) { return -1; }
-        break;
+      auto num_received = static_cast<uint32_t>(received.size());
+      zmq::message_t message(sizeof(num_received) + received.size() * sizeof(UserInterfaceMessageInjectionCommand));
+      memcpy(message.data(), &num_received, sizeof(num_received));
+      if (!received.empty()) {
+        memcpy(static_cast<char *>(message.data()) + sizeof(num_received),
+               received.data(),
+               received.size() * sizeof(UserInterfaceMessageInjectionCommand));
       }
-      case 4: { // retrieve all pseudonyms
-        int pseudonym_size = kPseudonymSize * sizeof(decltype(pseudonyms)::value_type::value_type);
+      return message;
+    }
+    default: {
+      // every request is answered, clients may wait for the reply
+      return zmq::message_t(0);
+    }
+  }
+}
 
-        zmq::message_t message(pseudonyms.size() * pseudonym_size);
-        auto msg_data_ptr = static_cast<char *>(message.data());
-        for (int i = 0; i < pseudonyms.size(); ++i) {
-          memcpy(msg_data_ptr + i * pseudonym_size, &pseudonyms[i], pseudonym_size);
-        }
+size_t network_manager::num_pseudonyms_left(size_t num_used) {
+  return static_cast<size_t>(kAMax) - std::min(num_used, static_cast<size_t>(kAMax));
+}
 
-        bool rc = user_socket_.send(message);
-        if (!rc) { return -1; }
-        break;
-      }
-      case 5: { // retrieve last pseudonym
+std::vector<std::array<uint8_t, kPseudonymSize>> network_manager::generate_pseudonyms(size_t count) {
+  // the enclave writes the pseudonyms into one contiguous buffer
+  static_assert(sizeof(std::array<uint8_t, kPseudonymSize>) == kPseudonymSize);
+  // the enclave generates at most kAMax pseudonyms in total (count may come from the peer interface)
+  count = std::min(count, num_pseudonyms_left(pseudonyms.size() + pseudonym_pool_.size()));
+  std::vector<std::array<uint8_t, kPseudonymSize>> generated(count);
+  size_t num_generated = 0;
+  if (count > 0) {
+    ecall_generate_pseudonyms(global_sgx_eid_, &num_generated, generated.front().data(), count);
+  }
+  if (num_generated < count) {
+    pseudonyms_exhausted_ = true;
+    generated.resize(num_generated);
+  }
+  return generated;
+}
 
-        std::string gen_pseud;
-        for (int i = 0; i < kPseudonymSize; i++) {
-          gen_pseud += std::to_string(pseudonyms[pseudonyms.size() - 1][i]) + " ";
-        }
-        std::cout << gen_pseud << std::endl;
+std::vector<std::array<uint8_t, kPseudonymSize>> network_manager::take_pseudonyms(size_t count) {
+  count = std::min(count, num_pseudonyms_left(pseudonyms.size()));
+  std::vector<std::array<uint8_t, kPseudonymSize>> taken;
+  taken.reserve(count);
+  for (; taken.size() < count && !pseudonym_pool_.empty(); pseudonym_pool_.pop_front()) {
+    taken.push_back(pseudonym_pool_.front());
+  }
+  if (taken.size() < count) {
+    auto generated = generate_pseudonyms(count - taken.size());
+    taken.insert(taken.end(), generated.begin(), generated.end());
+  }
+  pseudonyms.insert(pseudonyms.end(), taken.begin(), taken.end());
+  return taken;
+}
 
-        zmq::message_t message(gen_pseud.length());
-        memcpy(message.data(), gen_pseud.c_str(), gen_pseud.length());
-        bool rc = user_socket_.send(message);
-        if (!rc) { return -1; }
-        break;
+void network_manager::receive_loop() {
+  zmq::pollitem_t pollitems[] = {{static_cast<void *>(server_and_peer_socket_in_), 0, ZMQ_POLLIN, 0}};
+  while (running_.load(std::memory_order_relaxed)) {
+    zmq::poll(&pollitems[0], 1, POLL_INTERVAL);
+    if (!(pollitems[0].revents & ZMQ_POLLIN)) {
+      continue;
+    }
+    // drain everything that is ready without polling again
+    for (zmq::message_t msg_content; server_and_peer_socket_in_.recv(&msg_content, ZMQ_DONTWAIT);) {
+      if (msg_content.more()) { // (only the login server sends multi-part messages, see concatenate_parts())
+        msg_content = concatenate_parts(msg_content);
       }
-      default: {
-        break;
+      if (!push_waiting(incoming_, msg_content)) {
+        return;
       }
+      scheduler_.notify();
     }
   }
+}
 
+zmq::message_t network_manager::concatenate_parts(zmq::message_t &first_part) {
+  std::vector<zmq::message_t> parts;
+  parts.push_back(std::move(first_part));
+  while (parts.back().more()) {
+    parts.emplace_back();
+    bool rc = server_and_peer_socket_in_.recv(&parts.back());
+    assert(rc);
+  }
+  size_t size = 0;
+  for (const auto &part : parts) {
+    size += part.size();
+  }
+  zmq::message_t result(size);
+  auto *dst = static_cast<uint8_t *>(result.data());
+  for (const auto &part : parts) {
+    memcpy(dst, part.data(), part.size());
+    dst += part.size();
+  }
+  return result;
+}
+
+void network_manager::send_loop() {
+  OutgoingMessage outgoing;
+  while (running_.load(std::memory_order_relaxed)) {
+    if (!outgoing_.try_pop(outgoing)) {
+      // everything the enclave has produced so far has been handed to the transports, send the datagrams as a batch
+      if (udp_transport_) {
+        udp_transport_->flush();
+        num_udp_datagrams_.store(static_cast<int64_t>(udp_transport_->num_datagrams_sent()), std::memory_order_relaxed);
+        num_udp_batches_.store(static_cast<int64_t>(udp_transport_->num_batches_sent()), std::memory_order_relaxed);
+      }
+      send_doorbell_.wait(POLL_INTERVAL);
+      continue;
+    }
+
+    if (!outgoing.peer) {
+      bool rc = server_socket_out_.send(outgoing.payload);
+      assert(rc);
+      continue;
+    }
+
+    const auto &peer = *outgoing.peer;
+    auto &transport = transport_for_peer(peer, outgoing.connect_only);
+    if (outgoing.connect_only) {
+      continue;
+    }
+    if (!transport.send(peer, outgoing.payload)) { // shm link full or frame too large for UDP
+      zmq_transport_.connect(peer);
+      bool rc = zmq_transport_.send(peer, outgoing.payload);
+      assert(rc);
+      num_fallbacks_.fetch_add(1, std::memory_order_relaxed);
+    }
+    num_messages_sent_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+Transport &network_manager::transport_for_peer(const PeerInformation &peer, bool in_advance) {
+  auto transport_it = transports_.find(static_cast<uint64_t>(peer.id));
+  if (transport_it != transports_.end()) {
+    return *transport_it->second;
+  }
+
+  Transport *transport = &zmq_transport_;
+  if (shm_transport_ && shm_transport_->connect(peer)) {
+    transport = shm_transport_.get();
+    num_shm_links_.fetch_add(1, std::memory_order_relaxed);
+  } else if (udp_transport_) {
+    udp_transport_->connect(peer);
+    transport = udp_transport_.get();
+  } else {
+    zmq_transport_.connect(peer);
+  }
+  (in_advance ? num_pre_connected_ : num_connected_on_send_).fetch_add(1, std::memory_order_relaxed);
+  transports_.emplace(static_cast<uint64_t>(peer.id), transport);
+  return *transport;
+}
+
+void network_manager::shm_receive_loop() {
+  while (running_.load(std::memory_order_relaxed)) {
+    shm_transport_->wait(POLL_INTERVAL);
+    auto num_received = shm_transport_->receive([this](const uint8_t *data, size_t len) {
+      zmq::message_t msg_content(data, len);
+      push_waiting(incoming_shm_, msg_content);
+    });
+    if (num_received > 0) {
+      scheduler_.notify();
+    }
+  }
+}
 
-//server_socket_out_.close();
+void network_manager::udp_receive_loop() {
+  uint64_t num_rounds = 0;
+  while (running_.load(std::memory_order_relaxed)) {
+    if (num_rounds != num_rounds_.load(std::memory_order_relaxed)) {
+      num_rounds = num_rounds_.load(std::memory_order_relaxed);
+      udp_transport_->next_round();
+    }
+    if (!udp_transport_->wait(POLL_INTERVAL)) {
+      continue;
+    }
+    auto num_received = udp_transport_->receive([this](const uint8_t *data, size_t len) {
+      zmq::message_t msg_content(data, len);
+      push_waiting(incoming_udp_, msg_content);
+    });
+    if (num_received > 0) {
+      scheduler_.notify();
+    }
+  }
+}
 
-  return true;
+void network_manager::user_loop() {
+  zmq::pollitem_t pollitems[] = {{static_cast<void *>(user_socket_), 0, ZMQ_POLLIN, 0},
+                                 {nullptr, user_doorbell_.fd(), ZMQ_POLLIN, 0}};
+  // a request that did not fit into user_requests_ (no further requests are received until it has been pushed)
+  std::optional<UserRequest> pending;
+  while (running_.load(std::memory_order_relaxed)) {
+    pollitems[0].events = pending ? 0 : ZMQ_POLLIN;
+    zmq::poll(&pollitems[0], 2, POLL_INTERVAL);
+    if (pollitems[1].revents & ZMQ_POLLIN) {
+      user_doorbell_.reset();
+    }
+
+    // the replies are sent as soon as they are ready, the enclave thread never waits for a client
+    for (UserRequest reply; user_replies_.try_pop(reply);) {
+      bool rc = user_socket_.send(reply.identity, ZMQ_SNDMORE) && user_socket_.send(reply.request_id, ZMQ_SNDMORE)
+          && user_socket_.send(reply.payload);
+      assert(rc);
+    }
+    for (zmq::message_t event; user_events_.try_pop(event);) {
+      notify_socket_.send(event, ZMQ_DONTWAIT); // (PUB sockets never block, they drop for slow subscribers)
+    }
+
+    bool notify = false;
+    if (pending) {
+      if (!user_requests_.try_push(*pending)) {
+        continue;
+      }
+      pending.reset();
+      notify = true;
+    }
+    // drain everything that is ready: [identity][request id][command] (a missing request id is left empty)
+    for (UserRequest request; !pending && user_socket_.recv(&request.identity, ZMQ_DONTWAIT);) {
+      std::vector<zmq::message_t> parts;
+      while (request.identity.more() && (parts.empty() || parts.back().more())) {
+        parts.emplace_back();
+        bool rc = user_socket_.recv(&parts.back());
+        assert(rc);
+      }
+      if (parts.empty() || parts.size() > 2) {
+        std::cerr << "Ignoring a malformed request of the peer interface (" << parts.size() << " frames)" << std::endl;
+        continue;
+      }
+      request.payload = std::move(parts.back());
+      if (parts.size() == 2) {
+        request.request_id = std::move(parts.front());
+      } else {
+        request.request_id = zmq::message_t(0);
+      }
+      if (!user_requests_.try_push(request)) {
+        // do not wait for the enclave thread here: it may be waiting for user_replies_ to be drained
+        pending = std::move(request);
+      }
+      notify = true;
+    }
+    if (notify) {
+      scheduler_.notify();
+    }
+  }
 }
 
 void network_manager::set_global_sgx_eid_and_network_init(tee_enclave_id_t global_sgx_eid) {
@@ -200,39 +511,39 @@ void network_manager::set_global_sgx_eid_and_network_init(tee_enclave_id_t globa
 }
 
 void network_manager::send_msg_to_server(const void *ptr, size_t len) {
-  //s_sendmore(server_socket_out_, client_id_);
-
-  zmq::message_t message(len);
-  memcpy(message.data(), ptr, len);
-
-  bool rc = server_socket_out_.send(message);
+  OutgoingMessage outgoing{std::nullopt, zmq::message_t(ptr, len)};
+  bool rc = push_waiting(outgoing_, outgoing);
   assert(rc);
-  //return (rc);
-  //std::cout << "(UNTRUSTED) Sent message to login_server " << rc << std::endl;
+  send_doorbell_.ring();
 }
 
 void network_manager::send_msg_to_peer(const PeerInformation &peer, const uint8_t *ptr, size_t len) {
-  // if connection to recipient does not yet exist, establish it
-  if (peers_.count(static_cast<const unsigned long &>(peer.id)) < 1) {
-//    std::cout << "Establishing connection to peer " << std::string(peer.uri) << std::endl;
-    peers_.emplace(peer.id, Peer{zmq::socket_t(context_, ZMQ_DEALER)});
-    peers_.at(static_cast<const unsigned long &>(peer.id)).socket.connect("tcp://" + std::string(peer.uri));
-  }
-  // send message to recipient
-
-  zmq::message_t message(len);
-  memcpy(message.data(), ptr, len);
-
-  bool rc = peers_.at(static_cast<const unsigned long &>(peer.id)).socket.send(message);
+  OutgoingMessage outgoing{peer, zmq::message_t(ptr, len)};
+  bool rc = push_waiting(outgoing_, outgoing);
   assert(rc);
+  send_doorbell_.ring();
+}
 
-  /*if (peer.id == 0) {
-    std::cout << "Sent message to peer 0 with length " << len << std::endl;
-    //std::cout << "rc: " << rc << std::endl;
-  }*/
-  //return (rc);
-
+void network_manager::connect_to_peers(const std::vector<PeerInformation> &peers) {
+  for (const auto &peer : peers) {
+    OutgoingMessage outgoing{peer, zmq::message_t(), true};
+    bool rc = push_waiting(outgoing_, outgoing);
+    assert(rc);
+  }
+  send_doorbell_.ring();
+}
 
+ConnectionStatistics network_manager::get_connection_statistics() const {
+  auto num_pre_connected = num_pre_connected_.load(std::memory_order_relaxed);
+  auto num_connected_on_send = num_connected_on_send_.load(std::memory_order_relaxed);
+  return ConnectionStatistics{num_pre_connected + num_connected_on_send,
+                              num_pre_connected,
+                              num_connected_on_send,
+                              num_messages_sent_.load(std::memory_order_relaxed),
+                              num_shm_links_.load(std::memory_order_relaxed),
+                              num_fallbacks_.load(std::memory_order_relaxed),
+                              num_udp_datagrams_.load(std::memory_order_relaxed),
+                              num_udp_batches_.load(std::memory_order_relaxed)};
 }
 
 void network_manager::initialize(int port,
@@ -240,7 +551,11 @@ void network_manager::initialize(int port,
                                  const std::string &ip_self,
                                  const std::string &id_visualization,
                                  const std::string &port_in,
-                                 const std::string &interface_port_in) {
+                                 const std::string &interface_port_in,
+                                 const std::string &notify_port_in,
+                                 int io_threads,
+                                 bool use_shm,
+                                 bool use_udp) {
   // make sure that the in-ports are either * or a number
   if (port_in != "*") {
     assert(std::all_of(port_in.cbegin(), port_in.cend(), ::isdigit));
@@ -248,9 +563,21 @@ void network_manager::initialize(int port,
   if (interface_port_in != "*") {
     assert(std::all_of(interface_port_in.cbegin(), interface_port_in.cend(), ::isdigit));
   }
+  if (notify_port_in != "*") {
+    assert(std::all_of(notify_port_in.cbegin(), notify_port_in.cend(), ::isdigit));
+  }
+
+  // the number of I/O threads can only be changed before the first socket is created
+  assert(io_threads >= 1);
+  context_.setctxopt(ZMQ_IO_THREADS, io_threads);
+  server_socket_out_ = zmq::socket_t(context_, ZMQ_DEALER);
+  server_and_peer_socket_in_ = zmq::socket_t(context_, ZMQ_DEALER);
+  user_socket_ = zmq::socket_t(context_, ZMQ_ROUTER);
+  notify_socket_ = zmq::socket_t(context_, ZMQ_PUB);
 
   server_and_peer_socket_in_.setsockopt(ZMQ_LINGER, 0);
   user_socket_.setsockopt(ZMQ_LINGER, 0);
+  notify_socket_.setsockopt(ZMQ_LINGER, 0);
 
   try {
     server_and_peer_socket_in_.bind("tcp://" + ip_self + ":" + port_in);
@@ -284,14 +611,58 @@ void network_manager::initialize(int port,
     std::cout << "user socket is bound at port: " << user_port_ << std::endl;
   }
 
+  try {
+    notify_socket_.bind("tcp://" + ip_self + ":" + notify_port_in);
+  }
+  catch (zmq::error_t &e) {
+    std::cerr << "couldn't bind to socket (for delivery notifications): " << e.what();
+    abort();
+  }
+  size = sizeof(uri_chars);
+  notify_socket_.getsockopt(ZMQ_LAST_ENDPOINT, &uri_chars, &size);
+  notify_port_ = get_port_from_uri(uri_chars);
+
+  if (notify_port_in == "*") {
+    std::cout << "notify socket is bound at port: " << notify_port_ << std::endl;
+  }
+
   std::string url = ip_login_server + ":" + std::to_string(port);
   server_socket_out_.connect("tcp://" + url);
   server_socket_out_.setsockopt(ZMQ_LINGER, 0);
 
+  // peers on this host find the shared memory registry by the ip address and port of server_and_peer_socket_in_
+  if (use_shm) {
+    shm_transport_ = std::make_unique<ShmTransport>(ip_, in_port_, max_frame_size_);
+  }
+  // the UDP socket uses the same port number as server_and_peer_socket_in_ (so the peers know it from the uri)
+  if (use_udp) {
+    udp_transport_ = std::make_unique<UdpTransport>(ip_, in_port_, max_frame_size_);
+  }
+
   initialized_url_ = true;
+
+  running_ = true;
+  threads_.emplace_back(&network_manager::receive_loop, this);
+  threads_.emplace_back(&network_manager::send_loop, this);
+  threads_.emplace_back(&network_manager::user_loop, this);
+  if (shm_transport_) {
+    threads_.emplace_back(&network_manager::shm_receive_loop, this);
+  }
+  if (udp_transport_) {
+    threads_.emplace_back(&network_manager::udp_receive_loop, this);
+  }
+}
+
+void network_manager::stop() {
+  running_ = false;
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
 }
 
 network_manager::~network_manager() {
+  stop();
   server_socket_out_.close();
 }
 bool network_manager::isInitialized() const {
@@ -8,21 +8,95 @@
 
 #include <zmq.h>
 #include <zmq.hpp>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <thread>
 #include <unordered_map>
 #include "../../../include/message_structs.h"
+#include "round_scheduler.h"
+#include "shm_transport.h"
+#include "spsc_queue.h"
+#include "udp_transport.h"
+#include "zmq_transport.h"
 
 namespace c1::peer {
 
 /**
- * Struct encapsulating the socket of a peer.
+ * Message waiting for the send thread.
  */
-struct Peer {
-  zmq::socket_t socket;
-  Peer(zmq::socket_t &&socket) : socket(std::move(socket)) {}
+struct OutgoingMessage {
+  /** the recipient, the login server if empty */
+  std::optional<PeerInformation> peer;
+  zmq::message_t payload;
+  /** only establish the connection to peer, there is nothing to send */
+  bool connect_only = false;
+};
+
+/**
+ * Request of the peer interface or the reply to it (exchanged between the user thread and the enclave thread).
+ */
+struct UserRequest {
+  /** routing id of the client, assigned by the ROUTER socket */
+  zmq::message_t identity;
+  /** the request id chosen by the client (the empty delimiter frame for REQ clients), echoed in the reply */
+  zmq::message_t request_id;
+  /** the command (the first byte) and its arguments, or the reply */
+  zmq::message_t payload;
+};
+
+/**
+ * Connection metrics of the send thread (as returned to the peer interface).
+ */
+struct ConnectionStatistics {
+  /** number of connections to other peers (of any transport) */
+  int64_t num_peer_sockets;
+  /** number of connections established in advance (see network_manager::connect_to_peers()) */
+  int64_t num_pre_connected;
+  /** number of connections that had to be established when a message was to be sent (these delay the message) */
+  int64_t num_connected_on_send;
+  /** number of messages sent to other peers */
+  int64_t num_messages_sent;
+  /** number of connections to other peers that use shared memory (see ShmTransport) */
+  int64_t num_shm_links;
+  /** number of messages that had to be sent over ZeroMQ instead of the peer's transport (a shared memory link was
+   * full or a frame was too large for UDP) */
+  int64_t num_fallbacks;
+  /** number of datagrams sent via UDP (see UdpTransport) */
+  int64_t num_udp_datagrams;
+  /** number of sendmmsg calls used to send them */
+  int64_t num_udp_batches;
 };
 
 /**
  * Class to manage all network-related aspects.
+ * The sockets are served by dedicated threads so that a long running ecall never delays receiving or sending:
+ * the receive thread drains server_and_peer_socket_in_, the send thread owns all outgoing sockets (i.e., the
+ * transports) and the user thread owns user_socket_. If shared memory is enabled, the shm receive thread drains the
+ * links of the ShmTransport, if UDP is enabled, the udp receive thread drains the socket of the UdpTransport. They exchange messages with the enclave thread (the one calling MainLoop()) via SpscQueues and
+ * wake up the consuming thread with a Doorbell (the enclave thread waits in scheduler()).
+ *
+ * The peer interface is a ROUTER socket, so a client may keep many requests in flight. A DEALER client sends
+ * [request id][command] and gets [request id][reply], the request id is an arbitrary frame chosen by the client
+ * (e.g. a counter). REQ clients are served as well (their empty delimiter frame takes the place of the request id).
+ * The requests of a client are answered in the order they were sent. The command is a byte followed by its arguments:
+ *   - 0: generate a pseudonym, reply: the pseudonym as text
+ *   - 1: send a message, argument: UserInterfaceMessageInjectionCommand, reply: empty
+ *   - 2: receive a message, argument: UserInterfaceMessageInjectionCommand (n_dst), reply: the filled in command
+ *   - 3: get the time, reply: int64_t time and t_dst lower bound
+ *   - 4: get all pseudonyms, reply: the pseudonyms (kPseudonymSize bytes each)
+ *   - 5: get the last pseudonym, reply: the pseudonym as text
+ *   - 6: get the connection statistics, reply: ConnectionStatistics
+ *   - 7: send messages, arguments: uint32_t count and count UserInterfaceMessageInjectionCommands, reply: uint32_t
+ *        number of messages sent
+ *   - 8: generate pseudonyms, argument: uint32_t count, reply: the pseudonyms (kPseudonymSize bytes each)
+ *   - 9: receive all ready messages, arguments: uint32_t count and count pseudonyms (0: all pseudonyms generated via
+ *        this interface), reply: uint32_t number of messages and as many UserInterfaceMessageInjectionCommands
+ * Instead of polling with 2 or 9, clients may subscribe to notify_socket_ (a PUB socket, also served by the user
+ * thread): once a delivered message is due, an event [n_dst][int64_t t_dst] is published, so subscribing to a
+ * pseudonym yields the events of that pseudonym only. The events are checked at least once per round.
  */
 class network_manager {
  public:
@@ -42,31 +116,80 @@ class network_manager {
   void set_global_sgx_eid_and_network_init(tee_enclave_id_t global_sgx_eid);
 
   /**
-   * Called regularly.
-   * @return true
+   * Called regularly by the enclave thread: hands the received messages and the user requests to the enclave.
+   * @return true iff there was anything to process
    */
   bool MainLoop();
 
   /**
-   * Send message at ptr of length len to the login_server.
+   * Stop and join the network threads (called by the destructor).
+   */
+  void stop();
+
+  /** @return the scheduler the enclave thread waits in (it is notified whenever there is work for MainLoop()) */
+  RoundScheduler &scheduler() { return scheduler_; }
+
+  /**
+   * Send message at ptr of length len to the login_server (enqueued for the send thread).
    * @param ptr
    * @param len
    */
   void send_msg_to_server(const void *ptr, size_t len);
   /**
-   * Send message at ptr of length len to the peer given by peer.
+   * Send message at ptr of length len to the peer given by peer (enqueued for the send thread).
    * @param peer
    * @param ptr
    * @param len
    */
   void send_msg_to_peer(const PeerInformation &peer, const uint8_t *ptr, size_t len);
 
+  /**
+   * Establish the connections to the given peers in the background (the send thread connects to each of them unless
+   * it already has a socket for it).
+   * @param peers
+   */
+  void connect_to_peers(const std::vector<PeerInformation> &peers);
+
+  /**
+   * @return a snapshot of the connection metrics
+   */
+  ConnectionStatistics get_connection_statistics() const;
+
+  /**
+   * Keep up to size pseudonyms generated in advance, so the peer interface gets them without waiting for the enclave
+   * (the pool is filled by the enclave thread once the system has been initialized).
+   * @param size
+   */
+  void set_pseudonym_pool_size(size_t size) { pseudonym_pool_size_ = size; }
+
+  /**
+   * Set the size of the largest frame sent to another peer via shared memory or UDP (larger frames are sent over
+   * ZeroMQ). Has to be called before initialize() and be the same for all peers.
+   * @param size in bytes
+   */
+  void set_max_frame_size(size_t size) { max_frame_size_ = size; }
+
+  /** called by the enclave thread after every traffic_out (lets the receive threads drop outdated partial frames) */
+  void end_round() { num_rounds_.fetch_add(1, std::memory_order_relaxed); }
+
+  /**
+   * Called by the enclave thread when a message for one of the pseudonyms of this peer has been delivered: its event
+   * is published once the message is due (see MainLoop()).
+   * @param n_dst the pseudonym (kPseudonymSize bytes)
+   * @param t_dst the time from which on the message can be received
+   */
+  void message_delivered(const uint8_t *n_dst, round_t t_dst);
+
   void initialize(int port,
                   const std::string &ip_login_server,
                   const std::string &ip_self,
                   const std::string &id_visualization,
                   const std::string &port_in,
-                  const std::string &interface_port_in);
+                  const std::string &interface_port_in,
+                  const std::string &notify_port_in = "*",
+                  int io_threads = 1,
+                  bool use_shm = true,
+                  bool use_udp = false);
 
  private:
   /** zeromq context */
@@ -77,28 +200,81 @@ class network_manager {
   zmq::socket_t server_and_peer_socket_in_;
   /** the incoming socket for messages from the peer interface */
   zmq::socket_t user_socket_;
+  /** publishes the delivery events to the peer interface */
+  zmq::socket_t notify_socket_;
   /** global sgx eid, to be able to make ecalls */
   tee_enclave_id_t global_sgx_eid_;
-  /** poller for the login_server and peer in-socket */
-  zmq::pollitem_t pollitems_[1];
-  /** poller for the peer interface in-socket */
-  zmq::pollitem_t pollitems_user_[1];
+  /** messages received by the receive thread, consumed by the enclave thread */
+  SpscQueue<zmq::message_t> incoming_;
+  /** messages received by the shm receive thread, consumed by the enclave thread */
+  SpscQueue<zmq::message_t> incoming_shm_;
+  /** messages received by the udp receive thread, consumed by the enclave thread */
+  SpscQueue<zmq::message_t> incoming_udp_;
+  /** messages produced by the enclave thread, sent by the send thread */
+  SpscQueue<OutgoingMessage> outgoing_;
+  /** requests received by the user thread, answered by the enclave thread */
+  SpscQueue<UserRequest> user_requests_;
+  /** replies of the enclave thread to user_requests_ */
+  SpscQueue<UserRequest> user_replies_;
+  /** delivery events produced by the enclave thread, published by the user thread */
+  SpscQueue<zmq::message_t> user_events_;
+  /** the delivered messages that are not due yet as (t_dst, n_dst), the earliest first (only the enclave thread) */
+  std::priority_queue<std::pair<round_t, std::array<uint8_t, kPseudonymSize>>,
+                      std::vector<std::pair<round_t, std::array<uint8_t, kPseudonymSize>>>,
+                      std::greater<>> pending_deliveries_;
+  /** rung when outgoing_ is no longer empty */
+  Doorbell send_doorbell_;
+  /** rung when user_replies_ or user_events_ are no longer empty */
+  Doorbell user_doorbell_;
+  /** notified when incoming_ or user_requests_ are no longer empty */
+  RoundScheduler scheduler_;
+  /** the receive, send, user (and shm/udp receive) threads */
+  std::vector<std::thread> threads_;
+  /** cleared to make the network threads terminate */
+  std::atomic<bool> running_{false};
+  /** number of rounds ended so far (see end_round()) */
+  std::atomic<uint64_t> num_rounds_{0};
+  /** see set_max_frame_size() */
+  size_t max_frame_size_ = kDefaultMaxFrameSize;
+  /** connection metrics, written by the send thread only (see ConnectionStatistics) */
+  std::atomic<int64_t> num_pre_connected_{0};
+  std::atomic<int64_t> num_connected_on_send_{0};
+  std::atomic<int64_t> num_messages_sent_{0};
+  std::atomic<int64_t> num_shm_links_{0};
+  std::atomic<int64_t> num_fallbacks_{0};
+  std::atomic<int64_t> num_udp_datagrams_{0};
+  std::atomic<int64_t> num_udp_batches_{0};
   /** port of server_and_peer_socket_in_ */
   int in_port_{};
   /** port of user_socket_ */
   int user_port_{};
+  /** port of notify_socket_ */
+  int notify_port_{};
   /** the id used for the visualization */
   std::string id_visualization_;
   /** the ip stored as an array (because the enclave needs it that way) */
   std::array<uint8_t, 4> ip_{};
-  /** maps PeerInformation to peers */
-  std::unordered_map<uint64_t, Peer> peers_;
+  /** the default transport (only accessed by the send thread) */
+  ZmqTransport zmq_transport_;
+  /** the transport for peers on the same host, null if shared memory is disabled (sending: only by the send thread) */
+  std::unique_ptr<ShmTransport> shm_transport_;
+  /** the transport for all other peers if UDP is enabled, null otherwise (sending: only by the send thread) */
+  std::unique_ptr<UdpTransport> udp_transport_;
+  /** the transport chosen for each peer (by the id of the peer; only accessed by the send thread) */
+  std::unordered_map<uint64_t, Transport *> transports_;
   /** whether the system has already been initialized (login server's work is done, all peers have joined the system) */
   bool initialized_ = false;
   /** tells whether initialize() has been called */
   bool initialized_url_ = false;
 
+  /** the pseudonyms handed out to the peer interface */
   std::vector<std::array<uint8_t, kPseudonymSize>> pseudonyms;
+  /** pseudonyms generated in advance, not handed out yet (only the enclave thread) */
+  std::deque<std::array<uint8_t, kPseudonymSize>> pseudonym_pool_;
+  /** number of pseudonyms to keep in pseudonym_pool_ */
+  size_t pseudonym_pool_size_ = 0;
+  /** set once the enclave refuses to generate further pseudonyms (there is a maximum per peer) */
+  bool pseudonyms_exhausted_ = false;
 
  public:
   /**
@@ -121,6 +297,74 @@ class network_manager {
    * @return the IPv4 address as an array of four ints
    */
   static std::array<uint8_t, 4> get_ipv4_from_uri(const std::string &uri_str);
+
+  /** body of the receive thread */
+  void receive_loop();
+  /**
+   * Receive the remaining parts of a multi-part message (the init message and the topology sent by the login server)
+   * and concatenate them, so the enclave gets them in one buffer (receive thread only).
+   * @param first_part the part that has been received already
+   * @return
+   */
+  zmq::message_t concatenate_parts(zmq::message_t &first_part);
+  /** body of the send thread */
+  void send_loop();
+  /** body of the user thread */
+  void user_loop();
+  /** body of the shm receive thread */
+  void shm_receive_loop();
+  /** body of the udp receive thread */
+  void udp_receive_loop();
+
+  /**
+   * Return the transport for peer, connecting to peer if necessary (send thread only). Shared memory is preferred,
+   * all peers that cannot be reached via shared memory are reached via UDP if it is enabled, via ZeroMQ otherwise.
+   * @param peer
+   * @param in_advance whether the connection is established before there is a message for peer (for the metrics)
+   * @return
+   */
+  Transport &transport_for_peer(const PeerInformation &peer, bool in_advance);
+
+  /**
+   * Handle a request of the peer interface (on the enclave thread).
+   * @param request
+   * @return the reply to be sent to the peer interface
+   */
+  zmq::message_t handle_user_request(const zmq::message_t &request);
+
+  /**
+   * @param num_used number of pseudonyms this peer has already generated
+   * @return how many more the enclave generates (it generates at most kAMax in total)
+   */
+  static size_t num_pseudonyms_left(size_t num_used);
+
+  /**
+   * Generate count pseudonyms with a single ecall (enclave thread only).
+   * @param count
+   * @return the pseudonyms (fewer than count once the enclave refuses to generate more)
+   */
+  std::vector<std::array<uint8_t, kPseudonymSize>> generate_pseudonyms(size_t count);
+
+  /**
+   * Hand out count pseudonyms to the peer interface, taking them from pseudonym_pool_ first (enclave thread only).
+   * @param count
+   * @return the pseudonyms (also appended to pseudonyms)
+   */
+  std::vector<std::array<uint8_t, kPseudonymSize>> take_pseudonyms(size_t count);
+
+  /**
+   * Push value to queue, waiting while the queue is full (or until the network threads are stopped).
+   * @return false iff the value could not be pushed because the threads are stopped
+   */
+  template<typename T>
+  bool push_waiting(SpscQueue<T> &queue, T &value) {
+    for (Backoff backoff; !queue.try_push(value); backoff.wait()) {
+      if (!running_.load(std::memory_order_relaxed)) {
+        return false;
+      }
+    }
+    return true;
+  }
 };
 
 } //!namespace
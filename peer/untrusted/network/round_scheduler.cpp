@@ -0,0 +1,119 @@
+/**
+ * Event-driven waiting for the threads of the untrusted peer (instead of polling in a loop).
+ */
+
+#include "round_scheduler.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace c1::peer {
+
+/** abort with the error of the last system call (these only fail due to resource exhaustion) */
+static void fail(const char *what) {
+  perror(what);
+  abort();
+}
+
+Doorbell::Doorbell() : fd_{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)} {
+  if (fd_ < 0) {
+    fail("eventfd");
+  }
+}
+
+Doorbell::~Doorbell() {
+  close(fd_);
+}
+
+void Doorbell::ring() {
+  if (!rung_.exchange(true)) {
+    uint64_t one = 1;
+    // can only fail if the counter overflows, which cannot happen because only the first ring writes
+    [[maybe_unused]] auto rc = write(fd_, &one, sizeof(one));
+  }
+}
+
+void Doorbell::reset() {
+  uint64_t count;
+  while (read(fd_, &count, sizeof(count)) < 0 && errno == EINTR) {}
+  rung_.store(false);
+}
+
+bool Doorbell::wait(int timeout_ms) {
+  pollfd item{fd_, POLLIN, 0};
+  int rc = poll(&item, 1, timeout_ms);
+  if (rc < 0 && errno != EINTR) {
+    fail("poll");
+  }
+  if (rc > 0) {
+    reset();
+    return true;
+  }
+  return false;
+}
+
+RoundScheduler::RoundScheduler() : timer_fd_{timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC)},
+                                   epoll_fd_{epoll_create1(EPOLL_CLOEXEC)} {
+  if (timer_fd_ < 0) {
+    fail("timerfd_create");
+  }
+  if (epoll_fd_ < 0) {
+    fail("epoll_create1");
+  }
+  epoll_event work_event{};
+  work_event.events = EPOLLIN;
+  work_event.data.u32 = kWork;
+  epoll_event timer_event{};
+  timer_event.events = EPOLLIN;
+  timer_event.data.u32 = kRoundDue;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, work_.fd(), &work_event) < 0
+      || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &timer_event) < 0) {
+    fail("epoll_ctl");
+  }
+}
+
+RoundScheduler::~RoundScheduler() {
+  close(epoll_fd_);
+  close(timer_fd_);
+}
+
+void RoundScheduler::schedule_round(std::chrono::system_clock::time_point round_start) {
+  auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(round_start.time_since_epoch()).count();
+  itimerspec spec{};
+  // an all-zero it_value would disarm the timer instead of firing immediately
+  since_epoch = since_epoch > 0 ? since_epoch : 1;
+  spec.it_value.tv_sec = static_cast<time_t>(since_epoch / 1000000000);
+  spec.it_value.tv_nsec = static_cast<long>(since_epoch % 1000000000);
+  if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+    fail("timerfd_settime");
+  }
+}
+
+unsigned RoundScheduler::wait(bool block) {
+  epoll_event events[2];
+  int num_events = epoll_wait(epoll_fd_, events, 2, block ? -1 : 0);
+  if (num_events < 0 && errno != EINTR) {
+    fail("epoll_wait");
+  }
+
+  unsigned result = kNone;
+  for (int i = 0; i < num_events; ++i) {
+    result |= events[i].data.u32;
+  }
+  if (result & kWork) {
+    work_.reset();
+  }
+  if (result & kRoundDue) {
+    uint64_t expirations;
+    [[maybe_unused]] auto rc = read(timer_fd_, &expirations, sizeof(expirations));
+  }
+  return result;
+}
+
+} // !namespace
@@ -0,0 +1,88 @@
+/**
+ * Event-driven waiting for the threads of the untrusted peer (instead of polling in a loop).
+ */
+
+#ifndef ROUND_SCHEDULER_H
+#define ROUND_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+
+namespace c1::peer {
+
+/**
+ * Wakes up a thread that waits for new elements in its queue(s). Based on an eventfd, so it can be combined with other
+ * file descriptors (see RoundScheduler). Any thread may ring, only the waiting thread may call reset() and wait().
+ * Ringing a doorbell that has already been rung (and not been reset since) does not make a system call.
+ */
+class Doorbell {
+  int fd_;
+  std::atomic<bool> rung_{false};
+
+ public:
+  Doorbell();
+  ~Doorbell();
+  Doorbell(const Doorbell &) = delete;
+  Doorbell &operator=(const Doorbell &) = delete;
+
+  /** wake up the waiting thread (call after pushing to the queue) */
+  void ring();
+
+  /** acknowledge the wake-up (call before draining the queue, so that no element pushed afterwards is missed) */
+  void reset();
+
+  /**
+   * Wait until the doorbell is rung (and reset it).
+   * @param timeout_ms maximum time to wait in milliseconds (-1: infinite)
+   * @return true iff the doorbell was rung
+   */
+  bool wait(int timeout_ms);
+
+  /** @return the file descriptor that is readable while the doorbell is rung */
+  int fd() const { return fd_; }
+};
+
+/**
+ * Lets the enclave thread sleep until either a round starts or there is work (received messages or user requests).
+ * The round boundary is tracked by a timerfd, the work by a Doorbell, both are waited for with a single epoll.
+ */
+class RoundScheduler {
+  Doorbell work_;
+  int timer_fd_;
+  int epoll_fd_;
+
+ public:
+  /** the events returned by wait() (bit mask) */
+  enum Event : unsigned {
+    kNone = 0,
+    /** the doorbell has been rung */
+    kWork = 1,
+    /** the time given to schedule_round() has been reached */
+    kRoundDue = 2
+  };
+
+  RoundScheduler();
+  ~RoundScheduler();
+  RoundScheduler(const RoundScheduler &) = delete;
+  RoundScheduler &operator=(const RoundScheduler &) = delete;
+
+  /**
+   * Arm the timer (replacing the previous time).
+   * @param round_start the (wall clock) time at which the next round starts
+   */
+  void schedule_round(std::chrono::system_clock::time_point round_start);
+
+  /** called by the producers after they have pushed work for the enclave thread */
+  void notify() { work_.ring(); }
+
+  /**
+   * Wait for the next events.
+   * @param block false to only check for events that have already occurred
+   * @return the events (bit mask of Event)
+   */
+  unsigned wait(bool block);
+};
+
+} // !namespace
+
+#endif //ROUND_SCHEDULER_H
@@ -0,0 +1,150 @@
+/**
+ * Ring buffer for variable-sized frames that can be placed in memory shared between two processes.
+ */
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace c1::peer {
+
+/**
+ * Single-producer single-consumer ring of frames (byte strings) operating on a memory region it does not own (e.g. a
+ * shared memory segment mapped by a sender and a receiver process). The region starts with a Header, followed by
+ * capacity bytes of frame data. Every frame is stored as its length (8 bytes) followed by its bytes, padded to a
+ * multiple of 8. A frame that does not fit in front of the end of the data area is preceded by a wrap marker and
+ * stored at its beginning instead, so every frame is contiguous.
+ */
+class ShmRing {
+ public:
+  struct Header {
+    /** number of bytes consumed so far (only written by the consumer) */
+    alignas(64) std::atomic<uint64_t> head;
+    /** number of bytes produced so far (only written by the producer) */
+    alignas(64) std::atomic<uint64_t> tail;
+    uint64_t capacity;
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring requires address-free atomics");
+
+  /**
+   * @param capacity capacity of the data area in bytes (has to be a multiple of 8)
+   * @return the size of the memory region needed for a ring of that capacity
+   */
+  static constexpr size_t required_size(size_t capacity) {
+    return sizeof(Header) + capacity;
+  }
+
+  /**
+   * Initialize a new (empty) ring in memory (done by exactly one of the two processes).
+   * @param memory at least required_size(capacity) bytes, aligned to 64
+   * @param capacity capacity of the data area in bytes (has to be a multiple of 8)
+   * @return
+   */
+  static ShmRing create(void *memory, uint64_t capacity) {
+    auto header = new(memory) Header{};
+    header->head.store(0);
+    header->tail.store(0);
+    header->capacity = capacity;
+    return ShmRing(memory);
+  }
+
+  /**
+   * Use a ring that has been initialized with create() (possibly by another process).
+   * @param memory
+   * @return
+   */
+  static ShmRing attach(void *memory) {
+    return ShmRing(memory);
+  }
+
+  /**
+   * Append a frame (producer only).
+   * @param data
+   * @param len
+   * @return false iff there is currently not enough space for the frame (it is not appended then)
+   */
+  bool try_push(const void *data, size_t len) {
+    const uint64_t capacity = header_->capacity;
+    const uint64_t record_size = sizeof(uint64_t) + padded(len);
+    auto tail = header_->tail.load(std::memory_order_relaxed);
+    const uint64_t free = capacity - (tail - header_->head.load(std::memory_order_acquire));
+    const uint64_t pos = tail % capacity;
+    const uint64_t contiguous = capacity - pos;
+
+    const uint64_t skipped = record_size <= contiguous ? 0 : contiguous;
+    if (skipped + record_size > free) {
+      return false;
+    }
+    if (skipped > 0) {
+      write_length(pos, kWrapMarker);
+      tail += skipped;
+    }
+    const uint64_t start = tail % capacity;
+    write_length(start, len);
+    std::memcpy(data_ + start + sizeof(uint64_t), data, len);
+    header_->tail.store(tail + record_size, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Remove the oldest frame (consumer only).
+   * @tparam F callable as consume(const uint8_t *data, size_t len), the data is only valid during the call
+   * @param consume
+   * @return false iff the ring is empty
+   */
+  template<typename F>
+  bool try_pop(F &&consume) {
+    const uint64_t capacity = header_->capacity;
+    auto head = header_->head.load(std::memory_order_relaxed);
+    const auto tail = header_->tail.load(std::memory_order_acquire);
+    if (head == tail) {
+      return false;
+    }
+    uint64_t pos = head % capacity;
+    uint64_t len = read_length(pos);
+    if (len == kWrapMarker) {
+      head += capacity - pos;
+      pos = 0;
+      len = read_length(pos);
+    }
+    consume(data_ + pos + sizeof(uint64_t), static_cast<size_t>(len));
+    header_->head.store(head + sizeof(uint64_t) + padded(len), std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return header_->head.load(std::memory_order_acquire) == header_->tail.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr uint64_t kWrapMarker = ~uint64_t{0};
+
+  Header *header_;
+  uint8_t *data_;
+
+  explicit ShmRing(void *memory)
+      : header_(static_cast<Header *>(memory)), data_(static_cast<uint8_t *>(memory) + sizeof(Header)) {}
+
+  static uint64_t padded(size_t len) {
+    return (static_cast<uint64_t>(len) + 7) & ~uint64_t{7};
+  }
+
+  void write_length(uint64_t pos, uint64_t len) {
+    std::memcpy(data_ + pos, &len, sizeof(len));
+  }
+
+  uint64_t read_length(uint64_t pos) const {
+    uint64_t len;
+    std::memcpy(&len, data_ + pos, sizeof(len));
+    return len;
+  }
+};
+
+} // !namespace
+
+#endif //SHM_RING_H
@@ -0,0 +1,201 @@
+/**
+ * Transport sending messages through shared memory to peers running on the same host.
+ */
+
+#include "shm_transport.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace c1::peer {
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "the registry requires address-free atomics");
+
+/** futex operations on a word in shared memory (not FUTEX_PRIVATE_FLAG, the word is shared between processes) */
+static void futex_wait(std::atomic<uint32_t> &word, uint32_t expected, int timeout_ms) {
+  timespec timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t> &word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+ShmTransport::ShmTransport(const std::array<uint8_t, 4> &ip, int port, size_t max_frame_size)
+    : ip_(ip),
+      port_(static_cast<uint64_t>(port)),
+      link_capacity_(link_capacity(max_frame_size)),
+      registry_name_(segment_name(ip, port_)) {
+  registry_ = map_segment(registry_name_, sizeof(Registry), true);
+  if (registry_.address == nullptr) {
+    perror("couldn't create the shared memory registry");
+    abort();
+  }
+  new(registry_.address) Registry{};
+}
+
+ShmTransport::~ShmTransport() {
+  shm_unlink(registry_name_.c_str());
+  for (auto &[id, link] : out_links_) {
+    unmap(link.segment);
+    unmap(link.registry);
+  }
+  for (auto &link : in_links_) {
+    unmap(link.segment);
+  }
+  unmap(registry_);
+}
+
+bool ShmTransport::connect(const PeerInformation &peer) {
+  if (out_links_.count(static_cast<uint64_t>(peer.id)) > 0) {
+    return true;
+  }
+  const std::array<uint8_t, 4> peer_ip{peer.uri.ip1, peer.uri.ip2, peer.uri.ip3, peer.uri.ip4};
+  if (peer_ip != ip_) {
+    return false; // (most likely) another host
+  }
+
+  auto receiver_registry = map_segment(segment_name(peer_ip, peer.uri.port), sizeof(Registry), false);
+  if (receiver_registry.address == nullptr) {
+    return false; // the peer does not use shared memory
+  }
+  auto &registry = *static_cast<Registry *>(receiver_registry.address);
+  auto index = registry.num_links.fetch_add(1);
+  if (index >= kMaxShmLinks) {
+    unmap(receiver_registry);
+    return false;
+  }
+
+  auto name = link_name(peer_ip, peer.uri.port, ip_, port_);
+  auto segment = map_segment(name, ShmRing::required_size(link_capacity_), true);
+  if (segment.address == nullptr) {
+    // the entry stays reserved, the receiver skips it once it notices that the link does not exist
+    registry.sender_ports[index].store(port_, std::memory_order_release);
+    unmap(receiver_registry);
+    return false;
+  }
+  auto ring = ShmRing::create(segment.address, link_capacity_);
+  registry.sender_ports[index].store(port_, std::memory_order_release);
+  registry.signal.fetch_add(1);
+  futex_wake(registry.signal);
+
+  out_links_.emplace(static_cast<uint64_t>(peer.id), OutLink{segment, ring, receiver_registry});
+  return true;
+}
+
+bool ShmTransport::send(const PeerInformation &peer, zmq::message_t &payload) {
+  auto &link = out_links_.at(static_cast<uint64_t>(peer.id));
+  if (!link.ring.try_push(payload.data(), payload.size())) {
+    return false;
+  }
+  auto &registry = *static_cast<Registry *>(link.registry.address);
+  registry.signal.fetch_add(1);
+  if (registry.receiver_waiting.load()) {
+    futex_wake(registry.signal);
+  }
+  return true;
+}
+
+void ShmTransport::wait(int timeout_ms) {
+  auto &own = registry();
+  own.receiver_waiting.store(1);
+  auto signal = own.signal.load();
+  // check again after announcing the wait: a sender that has written before either changed signal or is visible here
+  bool empty = std::min<size_t>(own.num_links.load(), kMaxShmLinks) == num_accepted_links_;
+  for (const auto &link : in_links_) {
+    empty = empty && link.ring.empty();
+  }
+  if (empty) {
+    futex_wait(own.signal, signal, timeout_ms);
+  }
+  own.receiver_waiting.store(0);
+}
+
+size_t ShmTransport::receive(const std::function<void(const uint8_t *, size_t)> &consume) {
+  accept_new_links();
+  size_t num_frames = 0;
+  for (auto &link : in_links_) {
+    while (link.ring.try_pop(consume)) {
+      ++num_frames;
+    }
+  }
+  return num_frames;
+}
+
+void ShmTransport::accept_new_links() {
+  auto &own = registry();
+  auto num_links = std::min<size_t>(own.num_links.load(), kMaxShmLinks);
+  for (; num_accepted_links_ < num_links; ++num_accepted_links_) {
+    auto sender_port = own.sender_ports[num_accepted_links_].load(std::memory_order_acquire);
+    if (sender_port == 0) {
+      return; // the sender has not finished creating the link yet
+    }
+    auto name = link_name(ip_, port_, ip_, sender_port);
+    auto segment = map_segment(name, 0, false);
+    // the name is not needed any more once both sides have mapped the segment
+    shm_unlink(name.c_str());
+    if (segment.address != nullptr) { // otherwise, the sender failed to create the link (and uses ZeroMQ instead)
+      in_links_.push_back(InLink{segment, ShmRing::attach(segment.address)});
+    }
+  }
+}
+
+size_t ShmTransport::link_capacity(size_t max_frame_size) {
+  // a frame is stored as its length followed by its bytes padded to a multiple of 8 (see ShmRing)
+  return 2 * (sizeof(uint64_t) + ((max_frame_size + 7) & ~size_t{7}));
+}
+
+std::string ShmTransport::segment_name(const std::array<uint8_t, 4> &ip, uint64_t port) {
+  char name[64];
+  snprintf(name, sizeof(name), "/c1_%02x%02x%02x%02x_%llu", ip[0], ip[1], ip[2], ip[3],
+           static_cast<unsigned long long>(port));
+  return name;
+}
+
+std::string ShmTransport::link_name(const std::array<uint8_t, 4> &receiver_ip, uint64_t receiver_port,
+                                    const std::array<uint8_t, 4> &sender_ip, uint64_t sender_port) {
+  return segment_name(receiver_ip, receiver_port) + segment_name(sender_ip, sender_port).replace(0, 1, "_");
+}
+
+ShmTransport::Mapping ShmTransport::map_segment(const std::string &name, size_t size, bool create) {
+  int fd = create ? shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600) : shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return Mapping{};
+  }
+  // reserve the memory right away: a sparse segment would make the writer fail with SIGBUS once /dev/shm is full
+  if (create && posix_fallocate(fd, 0, static_cast<off_t>(size)) != 0) {
+    close(fd);
+    shm_unlink(name.c_str());
+    return Mapping{};
+  }
+  struct stat status{};
+  if (!create) {
+    size = fstat(fd, &status) == 0 ? static_cast<size_t>(status.st_size) : 0;
+  }
+  void *address = size > 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (address == MAP_FAILED) {
+    if (create) {
+      shm_unlink(name.c_str());
+    }
+    return Mapping{};
+  }
+  return Mapping{address, size};
+}
+
+void ShmTransport::unmap(Mapping &mapping) {
+  if (mapping.address != nullptr) {
+    munmap(mapping.address, mapping.size);
+    mapping = Mapping{};
+  }
+}
+
+} // !namespace
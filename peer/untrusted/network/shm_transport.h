@@ -0,0 +1,138 @@
+/**
+ * Transport sending messages through shared memory to peers running on the same host.
+ */
+
+#ifndef SHM_TRANSPORT_H
+#define SHM_TRANSPORT_H
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "shm_ring.h"
+#include "transport.h"
+
+namespace c1::peer {
+
+/** maximum number of peers that can send to a single peer through shared memory */
+constexpr size_t kMaxShmLinks{1024};
+
+/**
+ * Sends messages to peers on the same host through shared memory: every (sender, receiver) pair gets its own link, a
+ * shared memory segment holding an ShmRing written by the sender and read by the receiver.
+ * Every peer publishes a registry segment (named after its ip address and in-port). A sender creates the link segment
+ * and announces it in the receiver's registry; the receiver picks up new links from there. The registry also holds
+ * the futex the receiver sleeps on while all of its links are empty.
+ * A peer is only reached through shared memory if it has the same ip address and has published its registry, so peers
+ * on other hosts (and peers that disabled shared memory) are always reached over ZeroMQ. The memory of a link is
+ * reserved when the link is created (see link_capacity()), so a full /dev/shm makes the link fall back to ZeroMQ
+ * instead of failing when the ring is written to.
+ */
+class ShmTransport : public Transport {
+ public:
+  /** the registry segment of a peer */
+  struct Registry {
+    /** incremented by the senders after they have written to a link or added one (the receiver waits on it) */
+    std::atomic<uint32_t> signal;
+    /** whether the receiver is (about to be) waiting on signal, i.e., whether it has to be woken up */
+    std::atomic<uint32_t> receiver_waiting;
+    /** number of reserved entries in sender_ports */
+    std::atomic<uint32_t> num_links;
+    /** the in-ports of the senders of the links, 0 while an entry has been reserved but the link is not ready yet */
+    std::array<std::atomic<uint64_t>, kMaxShmLinks> sender_ports;
+  };
+
+  /**
+   * Publish the registry of this peer.
+   * @param ip ip address of this peer
+   * @param port in-port of this peer
+   * @param max_frame_size size of the largest frame sent through shared memory (larger ones are sent over ZeroMQ)
+   */
+  ShmTransport(const std::array<uint8_t, 4> &ip, int port, size_t max_frame_size);
+  ~ShmTransport() override;
+  ShmTransport(const ShmTransport &) = delete;
+  ShmTransport &operator=(const ShmTransport &) = delete;
+
+  bool connect(const PeerInformation &peer) override;
+  bool send(const PeerInformation &peer, zmq::message_t &payload) override;
+
+  /**
+   * Wait until a sender signals new data (receiving side).
+   * @param timeout_ms maximum time to wait in milliseconds
+   */
+  void wait(int timeout_ms);
+
+  /**
+   * Take all frames that have arrived on the links of this peer (receiving side).
+   * @param consume called for every frame, the data is only valid during the call
+   * @return the number of frames
+   */
+  size_t receive(const std::function<void(const uint8_t *, size_t)> &consume);
+
+  /** @return the number of links to other peers (outgoing) */
+  size_t num_links() const { return out_links_.size(); }
+
+  /**
+   * @param max_frame_size
+   * @return the capacity of the ring of a link: a peer sends one frame per round to each of its links, twice the space
+   * of the largest frame ensures that it fits into an empty ring wherever the previous frame ended
+   */
+  static size_t link_capacity(size_t max_frame_size);
+
+ private:
+  /** a mapped shared memory segment */
+  struct Mapping {
+    void *address = nullptr;
+    size_t size = 0;
+  };
+  /** an outgoing link */
+  struct OutLink {
+    Mapping segment;
+    ShmRing ring;
+    /** registry of the receiver */
+    Mapping registry;
+  };
+  /** an incoming link */
+  struct InLink {
+    Mapping segment;
+    ShmRing ring;
+  };
+
+  std::array<uint8_t, 4> ip_;
+  uint64_t port_;
+  /** capacity of the rings of the outgoing links */
+  size_t link_capacity_;
+  Mapping registry_;
+  std::string registry_name_;
+  /** links to other peers by the ids of the peers */
+  std::unordered_map<uint64_t, OutLink> out_links_;
+  /** links from other peers in the order of their registration */
+  std::vector<InLink> in_links_;
+  /** number of entries of the registry that have been processed by accept_new_links() */
+  size_t num_accepted_links_ = 0;
+
+  Registry &registry() { return *static_cast<Registry *>(registry_.address); }
+
+  static std::string segment_name(const std::array<uint8_t, 4> &ip, uint64_t port);
+  static std::string link_name(const std::array<uint8_t, 4> &receiver_ip, uint64_t receiver_port,
+                               const std::array<uint8_t, 4> &sender_ip, uint64_t sender_port);
+  /**
+   * Open (and map) a shared memory segment.
+   * @param name
+   * @param size size of the segment, only used if create is set
+   * @param create whether to create a new segment (replacing any segment with that name) instead of opening one, its
+   * memory is reserved
+   * @return the mapping, address is null if the segment could not be opened (or its memory could not be reserved)
+   */
+  static Mapping map_segment(const std::string &name, size_t size, bool create);
+  static void unmap(Mapping &mapping);
+
+  /** open the links that have been registered since the last call */
+  void accept_new_links();
+};
+
+} // !namespace
+
+#endif //SHM_TRANSPORT_H
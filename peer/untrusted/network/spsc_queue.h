@@ -0,0 +1,105 @@
+/**
+ * Bounded lock-free queue used to hand messages between the threads of the untrusted peer.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace c1::peer {
+
+/**
+ * Bounded single-producer single-consumer ring buffer. Exactly one thread may push and exactly one (other) thread may
+ * pop; neither of them ever blocks or takes a lock. The capacity is rounded up to a power of two.
+ * @tparam T type of the elements (has to be default constructible and move assignable)
+ */
+template<typename T>
+class SpscQueue {
+  std::vector<T> slots_;
+  size_t mask_;
+  /** index of the next element to be popped (only written by the consumer) */
+  alignas(64) std::atomic<size_t> head_{0};
+  /** index of the next free slot (only written by the producer) */
+  alignas(64) std::atomic<size_t> tail_{0};
+
+ public:
+  explicit SpscQueue(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size *= 2;
+    }
+    slots_.resize(size);
+    mask_ = size - 1;
+  }
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  /**
+   * Append an element (producer only).
+   * @param value moved from iff the element was appended
+   * @return false iff the queue is full
+   */
+  bool try_push(T &value) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+      return false;
+    }
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Remove the oldest element (consumer only).
+   * @param value receives the element
+   * @return false iff the queue is empty
+   */
+  bool try_pop(T &value) {
+    auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+  size_t capacity() const { return slots_.size(); }
+};
+
+/**
+ * Waiting strategy for threads that found their queue empty (or full): yield for a while (cheap while the other side
+ * is busy), then sleep for short periods so that an idle peer does not burn a core.
+ */
+class Backoff {
+  static constexpr unsigned kYieldRounds{64};
+  static constexpr std::chrono::microseconds kSleep{200};
+  unsigned rounds_ = 0;
+
+ public:
+  void wait() {
+    if (rounds_ < kYieldRounds) {
+      ++rounds_;
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(kSleep);
+    }
+  }
+
+  void reset() { rounds_ = 0; }
+};
+
+} // !namespace
+
+#endif //SPSC_QUEUE_H
@@ -0,0 +1,52 @@
+/**
+ * Interface of the ways the peer can send messages to other peers.
+ */
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <zmq.hpp>
+#include "../../../include/message_structs.h"
+
+namespace c1::peer {
+
+/**
+ * default size (in bytes) of the largest frame a peer sends to another peer in a round via shared memory or UDP, larger
+ * frames are sent over ZeroMQ (see the --max-frame-size option of the peer, which has to be the same for all peers)
+ */
+constexpr size_t kDefaultMaxFrameSize{256 * 1024};
+
+/**
+ * A way of sending messages to other peers (see ZmqTransport and ShmTransport). Transports are only used by the send
+ * thread of the network_manager, they do not have to be thread-safe. Receiving is up to the implementations.
+ */
+class Transport {
+ public:
+  virtual ~Transport() = default;
+
+  /**
+   * Establish the connection to peer (does nothing if it already exists).
+   * @param peer
+   * @return false iff peer cannot be reached with this transport
+   */
+  virtual bool connect(const PeerInformation &peer) = 0;
+
+  /**
+   * Send a message to a peer that has been connected with connect().
+   * @param peer
+   * @param payload the message (may be consumed if it has been sent)
+   * @return false iff the message could not be sent with this transport (payload is left intact then, so the caller
+   * may use another transport)
+   */
+  virtual bool send(const PeerInformation &peer, zmq::message_t &payload) = 0;
+
+  /**
+   * Hand the messages buffered by send() to the operating system (called by the send thread before it waits for new
+   * messages). Transports that do not buffer do not have to override this.
+   */
+  virtual void flush() {}
+};
+
+} // !namespace
+
+#endif //TRANSPORT_H
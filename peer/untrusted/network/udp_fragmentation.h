@@ -0,0 +1,217 @@
+/**
+ * Splitting of frames into UDP datagrams and their reassembly (see UdpTransport).
+ */
+
+#ifndef UDP_FRAGMENTATION_H
+#define UDP_FRAGMENTATION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace c1::peer {
+
+/** precedes the payload of every datagram */
+struct UdpFragmentHeader {
+  /** number of the frame (per sender) */
+  uint32_t message_id;
+  /** position of the fragment in the frame */
+  uint16_t index;
+  /** number of fragments of the frame */
+  uint16_t count;
+};
+
+/** maximum size of a datagram (an Ethernet MTU of 1500 bytes minus the IPv4 and UDP headers) */
+constexpr size_t kUdpDatagramSize{1472};
+/** maximum number of bytes of a frame in a single datagram */
+constexpr size_t kUdpFragmentPayload{kUdpDatagramSize - sizeof(UdpFragmentHeader)};
+/** maximum size of a frame that can be sent via UDP */
+constexpr size_t kUdpMaxFrameSize{UINT16_MAX * kUdpFragmentPayload};
+/** number of incomplete frames kept per sender, older ones are dropped (their fragments were most likely lost) */
+constexpr size_t kUdpMaxPartialFrames{16};
+/** default memory (in bytes) the incomplete frames of all senders may take up, the oldest ones are dropped beyond */
+constexpr size_t kUdpMaxPartialBytes{64 * 1024 * 1024};
+
+/**
+ * @param len size of a frame
+ * @return the number of datagrams needed for the frame (an empty frame still needs one)
+ */
+inline size_t udp_num_fragments(size_t len) {
+  return std::max<size_t>(1, (len + kUdpFragmentPayload - 1) / kUdpFragmentPayload);
+}
+
+/**
+ * Collects the fragments of the frames of all senders and hands out each frame once it is complete. Frames that
+ * consist of a single datagram are handed out without copying. Duplicate fragments are ignored.
+ * The datagrams are not authenticated, so the memory of the incomplete frames is bounded: a frame may not have more
+ * fragments than the largest frame the peers send, its buffer grows with the fragments that have arrived, and the
+ * incomplete frames are dropped (the oldest first) once they exceed a memory budget, once a sender has more than
+ * kUdpMaxPartialFrames of them or at the end of the round after the one they started in (see next_round()).
+ */
+class UdpReassembler {
+ public:
+  /**
+   * @param max_frame_size size of the largest frame sent via UDP (datagrams of larger frames are malformed)
+   * @param max_partial_bytes memory the incomplete frames may take up in total (at least one frame of max_frame_size)
+   */
+  explicit UdpReassembler(size_t max_frame_size, size_t max_partial_bytes = kUdpMaxPartialBytes)
+      : max_count_(udp_num_fragments(std::min(max_frame_size, kUdpMaxFrameSize))),
+        max_partial_bytes_(std::max(max_partial_bytes,
+                                    sizeof(Partial) + max_count_ / 8 + max_count_ * kUdpFragmentPayload)) {}
+
+  /**
+   * Add a received datagram.
+   * @tparam F callable as consume(const uint8_t *data, size_t len), the data is only valid during the call
+   * @param sender identifies the sender of the datagram (e.g. its address and port)
+   * @param datagram
+   * @param len size of the datagram
+   * @param consume called with the frame if the datagram completed it
+   * @return false iff the datagram is malformed (it is ignored then)
+   */
+  template<typename F>
+  bool add(uint64_t sender, const uint8_t *datagram, size_t len, F &&consume) {
+    UdpFragmentHeader header{};
+    if (len < sizeof(header)) {
+      return false;
+    }
+    std::memcpy(&header, datagram, sizeof(header));
+    const uint8_t *payload = datagram + sizeof(header);
+    const size_t payload_len = len - sizeof(header);
+    if (header.count == 0 || header.count > max_count_ || header.index >= header.count
+        || payload_len > kUdpFragmentPayload
+        || (header.index + 1 < header.count && payload_len != kUdpFragmentPayload)) {
+      return false;
+    }
+    if (header.count == 1) {
+      consume(payload, payload_len);
+      return true;
+    }
+
+    Partial *partial = find(sender, header.message_id);
+    if (partial == nullptr) {
+      auto sender_it = partials_.find(sender);
+      if (sender_it != partials_.end() && sender_it->second.size() == kUdpMaxPartialFrames) {
+        erase(sender, sender_it->second.begin()->first);
+      }
+      auto &sender_partials = partials_[sender];
+      partial = &sender_partials.emplace(header.message_id,
+                                         Partial(header.count, next_sequence_, round_)).first->second;
+      order_.emplace(next_sequence_++, std::make_pair(sender, header.message_id));
+      partial_bytes_ += partial->memory();
+    }
+    if (partial->received.size() != header.count || partial->received[header.index]) {
+      return partial->received.size() == header.count;
+    }
+    const size_t end = header.index * kUdpFragmentPayload + payload_len;
+    if (partial->data.size() < end) {
+      partial_bytes_ -= partial->memory();
+      partial->data.resize(end);
+      partial_bytes_ += partial->memory();
+      drop_oldest(partial->sequence);
+    }
+    partial->received[header.index] = true;
+    std::memcpy(partial->data.data() + header.index * kUdpFragmentPayload, payload, payload_len);
+    if (header.index + 1 == header.count) {
+      partial->size = end;
+    }
+    if (++partial->num_received == header.count) {
+      consume(partial->data.data(), partial->size);
+      erase(sender, header.message_id);
+    }
+    return true;
+  }
+
+  /**
+   * Called at the start of every round: drops the incomplete frames that were started before the previous round (the
+   * enclave would drop them as too late anyway).
+   */
+  void next_round() {
+    ++round_;
+    while (!order_.empty()) {
+      auto [sender, message_id] = order_.begin()->second;
+      if (find(sender, message_id)->round + 1 >= round_) {
+        return; // the frames are ordered by the time they were started
+      }
+      erase(sender, message_id);
+    }
+  }
+
+  /** @return the number of frames of which some but not all fragments have been received */
+  size_t num_partial_frames() const { return order_.size(); }
+
+  /** @return the memory taken up by the incomplete frames (in bytes, approximately) */
+  size_t partial_bytes() const { return partial_bytes_; }
+
+ private:
+  /** an incomplete frame */
+  struct Partial {
+    std::vector<bool> received;
+    /** the fragments received so far, extended up to the end of the fragment with the highest index */
+    std::vector<uint8_t> data;
+    size_t num_received = 0;
+    /** size of the frame, known once the last fragment has been received */
+    size_t size = 0;
+    /** position in the order in which the incomplete frames were started (see order_) */
+    uint64_t sequence;
+    /** the round (see next_round()) in which the first fragment arrived */
+    uint64_t round;
+
+    Partial(uint16_t count, uint64_t sequence, uint64_t round)
+        : received(count, false), sequence(sequence), round(round) {}
+
+    /** @return the memory taken up by this frame (counted against the budget) */
+    size_t memory() const { return sizeof(Partial) + received.capacity() / 8 + data.capacity(); }
+  };
+
+  Partial *find(uint64_t sender, uint32_t message_id) {
+    auto sender_it = partials_.find(sender);
+    if (sender_it == partials_.end()) {
+      return nullptr;
+    }
+    auto partial_it = sender_it->second.find(message_id);
+    return partial_it == sender_it->second.end() ? nullptr : &partial_it->second;
+  }
+
+  void erase(uint64_t sender, uint32_t message_id) {
+    auto sender_it = partials_.find(sender);
+    auto partial_it = sender_it->second.find(message_id);
+    partial_bytes_ -= partial_it->second.memory();
+    order_.erase(partial_it->second.sequence);
+    sender_it->second.erase(partial_it);
+    if (sender_it->second.empty()) {
+      partials_.erase(sender_it); // otherwise, every source port ever seen would keep an entry
+    }
+  }
+
+  /**
+   * Drop the oldest incomplete frames (except the one being extended) until the budget is met.
+   * @param keep sequence of the frame being extended
+   */
+  void drop_oldest(uint64_t keep) {
+    for (auto it = order_.begin(); partial_bytes_ > max_partial_bytes_ && it != order_.end();) {
+      auto [sequence, key] = *it++;
+      if (sequence != keep) {
+        erase(key.first, key.second);
+      }
+    }
+  }
+
+  /** largest number of fragments of a frame */
+  size_t max_count_;
+  size_t max_partial_bytes_;
+  /** the incomplete frames of each sender by their message ids (senders without any are removed) */
+  std::unordered_map<uint64_t, std::map<uint32_t, Partial>> partials_;
+  /** (sender, message id) of all incomplete frames by their sequence, i.e., the oldest first */
+  std::map<uint64_t, std::pair<uint64_t, uint32_t>> order_;
+  /** sum of Partial::memory() of all incomplete frames */
+  size_t partial_bytes_ = 0;
+  uint64_t next_sequence_ = 0;
+  uint64_t round_ = 0;
+};
+
+} // !namespace
+
+#endif //UDP_FRAGMENTATION_H
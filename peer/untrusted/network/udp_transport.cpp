@@ -0,0 +1,156 @@
+/**
+ * Transport sending messages as batches of UDP datagrams.
+ */
+
+#include "udp_transport.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace c1::peer {
+
+/** requested size of the socket buffers (a round's frames should fit, the kernel may cap it) */
+static constexpr int kUdpSocketBufferSize = 8 * 1024 * 1024;
+
+static sockaddr_in make_address(const std::array<uint8_t, 4> &ip, uint64_t port) {
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  std::memcpy(&address.sin_addr.s_addr, ip.data(), ip.size());
+  return address;
+}
+
+UdpTransport::UdpTransport(const std::array<uint8_t, 4> &ip, int port, size_t max_frame_size)
+    : fd_{socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0)},
+      max_frame_size_{std::min(max_frame_size, kUdpMaxFrameSize)},
+      receive_buffers_(kUdpBatchSize),
+      reassembler_(max_frame_size_) {
+  if (fd_ < 0) {
+    perror("couldn't create the UDP socket");
+    abort();
+  }
+  setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &kUdpSocketBufferSize, sizeof(kUdpSocketBufferSize));
+  setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &kUdpSocketBufferSize, sizeof(kUdpSocketBufferSize));
+  auto address = make_address(ip, static_cast<uint64_t>(port));
+  if (bind(fd_, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0) {
+    perror("couldn't bind the UDP socket");
+    abort();
+  }
+}
+
+UdpTransport::~UdpTransport() {
+  close(fd_);
+}
+
+bool UdpTransport::connect(const PeerInformation &peer) {
+  const std::array<uint8_t, 4> peer_ip{peer.uri.ip1, peer.uri.ip2, peer.uri.ip3, peer.uri.ip4};
+  addresses_.emplace(static_cast<uint64_t>(peer.id), make_address(peer_ip, peer.uri.port));
+  return true;
+}
+
+bool UdpTransport::send(const PeerInformation &peer, zmq::message_t &payload) {
+  if (payload.size() > max_frame_size_) {
+    return false;
+  }
+  const auto &address = addresses_.at(static_cast<uint64_t>(peer.id));
+  const auto *data = static_cast<const uint8_t *>(payload.data());
+  const auto count = static_cast<uint16_t>(udp_num_fragments(payload.size()));
+  const auto message_id = next_message_id_++;
+
+  for (uint16_t index = 0; index < count; ++index) {
+    const size_t begin = index * kUdpFragmentPayload;
+    const size_t len = std::min(kUdpFragmentPayload, payload.size() - begin);
+    const UdpFragmentHeader header{message_id, index, count};
+    const size_t offset = pending_data_.size();
+    pending_data_.resize(offset + sizeof(header) + len);
+    std::memcpy(pending_data_.data() + offset, &header, sizeof(header));
+    std::memcpy(pending_data_.data() + offset + sizeof(header), data + begin, len);
+    pending_.push_back(PendingDatagram{address, offset, sizeof(header) + len});
+  }
+  // keep the buffer small, a full batch is sent as efficiently as it gets anyway
+  if (pending_.size() >= kUdpBatchSize) {
+    flush();
+  }
+  return true;
+}
+
+void UdpTransport::flush() {
+  std::array<mmsghdr, kUdpBatchSize> messages{};
+  std::array<iovec, kUdpBatchSize> iovecs{};
+  size_t num_sent = 0;
+  while (num_sent < pending_.size()) {
+    const size_t batch_size = std::min(kUdpBatchSize, pending_.size() - num_sent);
+    for (size_t i = 0; i < batch_size; ++i) {
+      auto &datagram = pending_[num_sent + i];
+      iovecs[i] = iovec{pending_data_.data() + datagram.offset, datagram.len};
+      messages[i] = mmsghdr{};
+      messages[i].msg_hdr.msg_name = &datagram.address;
+      messages[i].msg_hdr.msg_namelen = sizeof(datagram.address);
+      messages[i].msg_hdr.msg_iov = &iovecs[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    int rc = sendmmsg(fd_, messages.data(), static_cast<unsigned>(batch_size), 0);
+    ++num_batches_sent_;
+    if (rc > 0) {
+      num_sent += static_cast<size_t>(rc);
+      num_datagrams_sent_ += static_cast<size_t>(rc);
+    } else if (errno != EINTR) {
+      // the first datagram could not be sent (e.g. the network is unreachable), it is lost like a dropped datagram
+      ++num_sent;
+    }
+  }
+  pending_.clear();
+  pending_data_.clear();
+}
+
+bool UdpTransport::wait(int timeout_ms) {
+  pollfd item{fd_, POLLIN, 0};
+  int rc = poll(&item, 1, timeout_ms);
+  if (rc < 0 && errno != EINTR) {
+    perror("poll");
+    abort();
+  }
+  return rc > 0;
+}
+
+size_t UdpTransport::receive(const std::function<void(const uint8_t *, size_t)> &consume) {
+  std::array<mmsghdr, kUdpBatchSize> messages{};
+  std::array<iovec, kUdpBatchSize> iovecs{};
+  std::array<sockaddr_in, kUdpBatchSize> senders{};
+  size_t num_frames = 0;
+  auto count_frame = [&consume, &num_frames](const uint8_t *data, size_t len) {
+    consume(data, len);
+    ++num_frames;
+  };
+
+  while (true) {
+    for (size_t i = 0; i < kUdpBatchSize; ++i) {
+      iovecs[i] = iovec{receive_buffers_[i].data(), receive_buffers_[i].size()};
+      messages[i] = mmsghdr{};
+      messages[i].msg_hdr.msg_name = &senders[i];
+      messages[i].msg_hdr.msg_namelen = sizeof(senders[i]);
+      messages[i].msg_hdr.msg_iov = &iovecs[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    int rc = recvmmsg(fd_, messages.data(), kUdpBatchSize, MSG_DONTWAIT, nullptr);
+    if (rc <= 0) {
+      return num_frames; // EAGAIN: the socket has been drained
+    }
+    for (int i = 0; i < rc; ++i) {
+      if (messages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+        continue; // not sent by a UdpTransport
+      }
+      const uint64_t sender = (static_cast<uint64_t>(senders[i].sin_addr.s_addr) << 16) | senders[i].sin_port;
+      reassembler_.add(sender, receive_buffers_[i].data(), messages[i].msg_len, count_frame);
+    }
+    if (static_cast<size_t>(rc) < kUdpBatchSize) {
+      return num_frames;
+    }
+  }
+}
+
+} // !namespace
@@ -0,0 +1,97 @@
+/**
+ * Transport sending messages as batches of UDP datagrams.
+ */
+
+#ifndef UDP_TRANSPORT_H
+#define UDP_TRANSPORT_H
+
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <netinet/in.h>
+#include "transport.h"
+#include "udp_fragmentation.h"
+
+namespace c1::peer {
+
+/** maximum number of datagrams sent with one sendmmsg (or received with one recvmmsg) */
+constexpr size_t kUdpBatchSize{64};
+
+/**
+ * Sends messages to other peers as UDP datagrams from a single socket bound to the ip address and in-port of the peer
+ * (the port number of server_and_peer_socket_in_, see network_manager). send() only splits the message into datagrams
+ * (see UdpReassembler) and queues them, flush() sends all queued datagrams with as few sendmmsg calls as possible.
+ * The receiving side drains the socket with recvmmsg.
+ * UDP does not retransmit lost datagrams. This is fine for the traffic between peers: it is round-based and the
+ * enclave drops frames that arrive late anyway. All peers of the network have to use the UDP transport (a peer
+ * without it does not receive the datagrams), only frames larger than max_frame_size are sent over ZeroMQ.
+ */
+class UdpTransport : public Transport {
+ public:
+  /**
+   * Bind the socket.
+   * @param ip ip address of this peer
+   * @param port in-port of this peer
+   * @param max_frame_size size of the largest frame sent via UDP (has to be the same for all peers)
+   */
+  UdpTransport(const std::array<uint8_t, 4> &ip, int port, size_t max_frame_size);
+  ~UdpTransport() override;
+  UdpTransport(const UdpTransport &) = delete;
+  UdpTransport &operator=(const UdpTransport &) = delete;
+
+  bool connect(const PeerInformation &peer) override;
+  bool send(const PeerInformation &peer, zmq::message_t &payload) override;
+  void flush() override;
+
+  /**
+   * Wait until datagrams arrive (receiving side).
+   * @param timeout_ms maximum time to wait in milliseconds
+   * @return true iff there are datagrams to receive
+   */
+  bool wait(int timeout_ms);
+
+  /**
+   * Take all datagrams that have arrived and hand out the completed frames (receiving side).
+   * @param consume called for every frame, the data is only valid during the call
+   * @return the number of frames
+   */
+  size_t receive(const std::function<void(const uint8_t *, size_t)> &consume);
+
+  /** drop the frames that are still incomplete from before the previous round (receiving side) */
+  void next_round() { reassembler_.next_round(); }
+
+  /** @return the number of datagrams sent so far */
+  size_t num_datagrams_sent() const { return num_datagrams_sent_; }
+  /** @return the number of system calls used to send them */
+  size_t num_batches_sent() const { return num_batches_sent_; }
+
+ private:
+  /** a datagram waiting for flush() */
+  struct PendingDatagram {
+    sockaddr_in address;
+    /** index of the first byte of the datagram (header and payload) in pending_data_ */
+    size_t offset;
+    size_t len;
+  };
+
+  int fd_;
+  size_t max_frame_size_;
+  /** the addresses of the peers by their ids */
+  std::unordered_map<uint64_t, sockaddr_in> addresses_;
+  /** id of the next message sent (the same sequence is used for all receivers) */
+  uint32_t next_message_id_ = 0;
+  std::vector<PendingDatagram> pending_;
+  /** the contents of pending_ */
+  std::vector<uint8_t> pending_data_;
+  size_t num_datagrams_sent_ = 0;
+  size_t num_batches_sent_ = 0;
+
+  /** buffers for recvmmsg (receiving side) */
+  std::vector<std::array<uint8_t, kUdpDatagramSize>> receive_buffers_;
+  UdpReassembler reassembler_;
+};
+
+} // !namespace
+
+#endif //UDP_TRANSPORT_H
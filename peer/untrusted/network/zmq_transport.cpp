@@ -0,0 +1,26 @@
+/**
+ * Transport sending messages over ZeroMQ (TCP), the default for all peers.
+ */
+
+#include "zmq_transport.h"
+#include <cassert>
+
+namespace c1::peer {
+
+bool ZmqTransport::connect(const PeerInformation &peer) {
+  if (peers_.count(static_cast<uint64_t>(peer.id)) > 0) {
+    return true;
+  }
+  auto &socket = peers_.emplace(peer.id, Peer{zmq::socket_t(context_, ZMQ_DEALER)}).first->second.socket;
+  socket.setsockopt(ZMQ_LINGER, 0);
+  socket.connect("tcp://" + std::string(peer.uri));
+  return true;
+}
+
+bool ZmqTransport::send(const PeerInformation &peer, zmq::message_t &payload) {
+  bool rc = peers_.at(static_cast<uint64_t>(peer.id)).socket.send(payload);
+  assert(rc);
+  return rc;
+}
+
+} // !namespace
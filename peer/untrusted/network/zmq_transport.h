@@ -0,0 +1,41 @@
+/**
+ * Transport sending messages over ZeroMQ (TCP), the default for all peers.
+ */
+
+#ifndef ZMQ_TRANSPORT_H
+#define ZMQ_TRANSPORT_H
+
+#include <zmq.h>
+#include <zmq.hpp>
+#include <unordered_map>
+#include "transport.h"
+
+namespace c1::peer {
+
+/**
+ * Struct encapsulating the socket of a peer.
+ */
+struct Peer {
+  zmq::socket_t socket;
+  Peer(zmq::socket_t &&socket) : socket(std::move(socket)) {}
+};
+
+/**
+ * Sends messages through one DEALER socket per peer (the messages are received by the peer's
+ * server_and_peer_socket_in_, see network_manager).
+ */
+class ZmqTransport : public Transport {
+  zmq::context_t &context_;
+  /** maps the ids of the peers to their sockets */
+  std::unordered_map<uint64_t, Peer> peers_;
+
+ public:
+  explicit ZmqTransport(zmq::context_t &context) : context_(context) {}
+
+  bool connect(const PeerInformation &peer) override;
+  bool send(const PeerInformation &peer, zmq::message_t &payload) override;
+};
+
+} // !namespace
+
+#endif //ZMQ_TRANSPORT_H
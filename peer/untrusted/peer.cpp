@@ -5,13 +5,6 @@
 
 #include "peer.h"
 #include <iostream>
-#ifdef BUILD_WITH_VISUALIZATION
-#include <json/json.h>
-#include <curlpp/cURLpp.hpp>
-#include <curlpp/Easy.hpp>
-#include <curlpp/Options.hpp>
-#include "../include/vis_data.h"
-#endif
 #include "enclave_u_substitute.h"
 #include "../../include/receiver_blob_pair.h"
 
@@ -22,6 +15,22 @@ Client::Client() : global_eid_(0), network_manager_() {}
 void Client::set_vis_ip(const std::string &vis_ip) {
   vis_ip_ = vis_ip;
   visualization_on_ = true;
+#ifdef BUILD_WITH_VISUALIZATION
+  vis_exporter_ = std::make_unique<VisExporter>(vis_ip_);
+#endif
+}
+
+void Client::set_vis_sampling(uint32_t round_interval, uint32_t peer_modulus) {
+  vis_round_interval_ = round_interval;
+  vis_peer_modulus_ = peer_modulus;
+}
+
+void Client::set_pseudonym_pool_size(size_t size) {
+  network_manager_.set_pseudonym_pool_size(size);
+}
+
+void Client::set_max_frame_size(size_t size) {
+  network_manager_.set_max_frame_size(size);
 }
 
 void Client::initialize_network_manager(int port,
@@ -29,35 +38,62 @@ void Client::initialize_network_manager(int port,
                                         const std::string &ip_self,
                                         const std::string &id_visualization,
                                         const std::string &port_in,
-                                        const std::string &interface_port_in) {
-  network_manager_.initialize(port, ip_login_server, ip_self, id_visualization, port_in, interface_port_in);
+                                        const std::string &interface_port_in,
+                                        const std::string &notify_port_in,
+                                        int io_threads,
+                                        bool use_shm,
+                                        bool use_udp) {
+  network_manager_.initialize(port,
+                              ip_login_server,
+                              ip_self,
+                              id_visualization,
+                              port_in,
+                              interface_port_in,
+                              notify_port_in,
+                              io_threads,
+                              use_shm,
+                              use_udp);
 }
 
 int Client::run() {
   ecall_init(global_eid_);
+#ifdef BUILD_WITH_VISUALIZATION
+  // the enclave captures nothing for the visualization unless it is switched on here
+  ecall_set_visualization(global_eid_, visualization_on_, vis_round_interval_, vis_peer_modulus_);
+#endif
 
   /* Inform the network manager of the global_eid_ */
   network_manager_.set_global_sgx_eid_and_network_init(global_eid_);
 
-  //main loop
-  for (auto start = std::chrono::system_clock::now(); true;) { // infinite (main!) loop
-    if (!network_manager_.MainLoop()) {
-      break;
-    }
+  //main loop: sleep until there is work or the next round starts
+  auto &scheduler = network_manager_.scheduler();
+  bool busy = false;
+  bool round_scheduled = false;
+  while (true) { // infinite (main!) loop
+    auto events = scheduler.wait(!busy); // do not sleep while there may be messages left
+    busy = network_manager_.MainLoop();
     if (!network_manager_.isInitialized()) {
       continue; // no response from the login_server yet, so don't call traffic_out yet
     }
+    if (round_scheduled && !(events & RoundScheduler::kRoundDue)) {
+      continue; // traffic_out only has to be called once every round
+    }
 
-    std::chrono::duration<double> time_diff = std::chrono::system_clock::now() - start;
-    //   if (time_diff.count() >= static_cast<double>(kDelta) / 2.0) {
-    start = std::chrono::system_clock::now();
+    auto start = std::chrono::system_clock::now();
     int ret_val;
     ecall_traffic_out(global_eid_, &ret_val);
+    network_manager_.end_round();
     if (std::round(std::chrono::duration<double>(std::chrono::system_clock::now() - start).count()) > 0) {
       std::cout << "TrafficOut took time: "
                 << std::round(std::chrono::duration<double>(std::chrono::system_clock::now() - start).count())
                 << "\n";
     }
+
+    // the trusted time (in milliseconds) of the substitute TEE is based on the system clock
+    int64_t next_round_time;
+    ecall_get_next_round_time(global_eid_, &next_round_time);
+    scheduler.schedule_round(std::chrono::system_clock::time_point(std::chrono::milliseconds(next_round_time)));
+    round_scheduled = true;
   }
 
   printf("Info: SampleEnclave successfully returned.\n");
@@ -82,51 +118,22 @@ void Client::traffic_out_return(const uint8_t *ptr, size_t len) {
 
 }
 
-void Client::vis_data(const uint8_t *ptr, size_t len) {
-#ifdef BUILD_WITH_VISUALIZATION
-  if (!visualization_on_) {
-    return;
-  }
-
+void Client::connect_to_peers(const uint8_t *ptr, size_t len) {
   size_t cur = 0;
   std::vector<uint8_t> working_vec(ptr, ptr + len);
+  network_manager_.connect_to_peers(deserialize_vec<PeerInformation>(working_vec, cur));
+}
 
-  auto vis_data_deserialized = VisData::deserialize(working_vec, cur);
-  auto vis_data_json = vis_data_deserialized.to_json();
-
-  Json::StreamWriterBuilder builder;
-  builder.settings_["indentation"] = "";
-  std::string vis_data_json_string = Json::writeString(builder, vis_data_json);
-
-  try {
-    curlpp::Cleanup cleaner;
-    curlpp::Easy request;
-
-    std::string url = "http://" + vis_ip_ + ":8080/";
-    //std::string url = "http://funda.cs.upb.de/test.php";
-
-    request.setOpt(new curlpp::options::Url(url));
-    request.setOpt(new curlpp::options::Timeout(2));
-    //request.setOpt(new curlpp::options::Verbose(true));
-
-    std::list<std::string> header;
-    header.emplace_back("Content-Type: application/application/json");
-
-    request.setOpt(new curlpp::options::HttpHeader(header));
-
-    request.setOpt(new curlpp::options::PostFields(vis_data_json_string));
-    request.setOpt(new curlpp::options::PostFieldSize(-1));
+void Client::message_delivered(const uint8_t *n_dst, int64_t t_dst) {
+  network_manager_.message_delivered(n_dst, t_dst);
+}
 
-    request.perform();
-  }
-  catch (curlpp::LogicError &e) {
-    std::cout << e.what() << std::endl;
-  }
-  catch (curlpp::RuntimeError &e) {
-    std::cout << e.what() << std::endl;
+void Client::vis_data([[maybe_unused]] const uint8_t *ptr, [[maybe_unused]] size_t len) {
+#ifdef BUILD_WITH_VISUALIZATION
+  if (!visualization_on_) {
+    return;
   }
-
-  std::cout << "\n";
+  vis_exporter_->push(ptr, len);
 #endif
 }
 
@@ -153,7 +160,17 @@ void ocall_traffic_out_return(const uint8_t *ptr, size_t len) {
   c1::peer::Client::instance().traffic_out_return(ptr, len);
 }
 
+/* ocall to establish connections in advance */
+void ocall_connect_to_peers(const uint8_t *ptr, size_t len) {
+  c1::peer::Client::instance().connect_to_peers(ptr, len);
+}
+
 /* ocall function to handle the visualization data */
 void ocall_vis_data(const uint8_t *ptr, size_t len) {
   c1::peer::Client::instance().vis_data(ptr, len);
 }
+
+/* ocall to notify the peer interface about delivered messages */
+void ocall_message_delivered(const uint8_t n_dst[8], int64_t t_dst) {
+  c1::peer::Client::instance().message_delivered(n_dst, t_dst);
+}
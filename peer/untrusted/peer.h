@@ -7,6 +7,9 @@
 #define PEER_H
 
 #include "network/network_manager.h"
+#ifdef BUILD_WITH_VISUALIZATION
+#include "vis_exporter.h"
+#endif
 #include <cstdio>
 
 namespace c1::peer {
@@ -25,14 +28,37 @@ class Client {
 
   void set_vis_ip(const std::string &vis_ip);
 
+  /**
+   * Select the rounds and peers reported to the visualization (see ClientEnclave::set_visualization())
+   * @param round_interval report every round_interval-th round
+   * @param peer_modulus report only if the id of this peer is a multiple of peer_modulus
+   */
+  void set_vis_sampling(uint32_t round_interval, uint32_t peer_modulus);
+
+  /**
+   * see network_manager::set_pseudonym_pool_size()
+   * @param size
+   */
+  void set_pseudonym_pool_size(size_t size);
+
+  /**
+   * see network_manager::set_max_frame_size()
+   * @param size
+   */
+  void set_max_frame_size(size_t size);
+
   void initialize_network_manager(int port,
                                   const std::string &ip_login_server,
                                   const std::string &ip_self,
                                   const std::string &id_visualization,
                                   const std::string &port_in,
-                                  const std::string &interface_port_in);
+                                  const std::string &interface_port_in,
+                                  const std::string &notify_port_in,
+                                  int io_threads,
+                                  bool use_shm,
+                                  bool use_udp);
 
-  /** main loop (infinite) */
+  /** main loop (infinite), runs the enclave thread */
   int run();
 
   void send_msg_to_server(const void *ptr, size_t len);
@@ -44,12 +70,28 @@ class Client {
   void traffic_out_return(const uint8_t *ptr, size_t len);
 
   /**
-   * Used to send data to the visualization server. Does nothing if use_visualization_ is set to false.
+   * Used by the enclave to announce the peers it is going to communicate with (so that they are connected in advance)
+   * @param ptr ptr to the serialized peers
+   * @param len its length
+   */
+  void connect_to_peers(const uint8_t *ptr, size_t len);
+
+  /**
+   * Used to send data to the visualization server (handed to vis_exporter_, so the enclave does not wait for the
+   * server). Does nothing if use_visualization_ is set to false.
    * @param ptr
    * @param len
    */
   void vis_data(const uint8_t *ptr, size_t len);
 
+  /**
+   * Used by the enclave to announce that a message for one of its pseudonyms has been delivered (see
+   * network_manager::message_delivered())
+   * @param n_dst the pseudonym
+   * @param t_dst the time from which on the message can be received
+   */
+  void message_delivered(const uint8_t *n_dst, int64_t t_dst);
+
  private:
   Client();
 
@@ -58,6 +100,12 @@ class Client {
   network_manager network_manager_;
   std::string vis_ip_;
   bool visualization_on_ = false;
+  uint32_t vis_round_interval_ = 1;
+  uint32_t vis_peer_modulus_ = 1;
+#ifdef BUILD_WITH_VISUALIZATION
+  /** sends the visualization data in the background, created by set_vis_ip() */
+  std::unique_ptr<VisExporter> vis_exporter_;
+#endif
 };
 
 } // ~namespace
@@ -69,7 +117,9 @@ extern "C" {
 void ocall_print_string(const char *str);
 void ocall_send_msg_to_server(const uint8_t *ptr, size_t len);
 void ocall_traffic_out_return(const uint8_t *ptr, size_t len);
+void ocall_connect_to_peers(const uint8_t *ptr, size_t len);
 void ocall_vis_data(const uint8_t *ptr, size_t len);
+void ocall_message_delivered(const uint8_t n_dst[8], int64_t t_dst);
 
 #if defined(__cplusplus)
 }
@@ -0,0 +1,97 @@
+/**
+ * Sends the visualization data of the rounds to the visualization server in the background.
+ */
+
+#include "vis_exporter.h"
+#include <iostream>
+#include <json/json.h>
+#include <curlpp/cURLpp.hpp>
+#include <curlpp/Easy.hpp>
+#include <curlpp/Options.hpp>
+#include "../include/vis_data.h"
+
+namespace c1::peer {
+
+VisExporter::VisExporter(const std::string &vis_ip)
+    : url_{"http://" + vis_ip + ":8080/"}, thread_{&VisExporter::run, this} {}
+
+VisExporter::~VisExporter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  cv_.notify_one();
+  thread_.join();
+}
+
+void VisExporter::push(const uint8_t *ptr, size_t len) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.size() == kVisQueueCapacity) {
+      queue_.pop_front();
+      ++num_dropped_;
+    }
+    queue_.emplace_back(ptr, ptr + len);
+  }
+  cv_.notify_one();
+}
+
+size_t VisExporter::num_dropped() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_dropped_;
+}
+
+void VisExporter::run() {
+  curlpp::Cleanup cleaner;
+  std::vector<std::vector<uint8_t>> batch;
+  while (true) {
+    batch.clear();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+      if (!running_) {
+        return;
+      }
+      while (!queue_.empty() && batch.size() < kVisMaxBatch) {
+        batch.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+    }
+    post(batch);
+  }
+}
+
+void VisExporter::post(const std::vector<std::vector<uint8_t>> &batch) {
+  Json::Value rounds(Json::arrayValue);
+  for (const auto &serialized : batch) {
+    size_t cur = 0;
+    rounds.append(VisData::deserialize(serialized, cur).to_json());
+  }
+
+  Json::StreamWriterBuilder builder;
+  builder.settings_["indentation"] = "";
+  std::string rounds_json_string = Json::writeString(builder, rounds);
+
+  try {
+    curlpp::Easy request;
+    request.setOpt(new curlpp::options::Url(url_));
+    request.setOpt(new curlpp::options::Timeout(2));
+
+    std::list<std::string> header;
+    header.emplace_back("Content-Type: application/json");
+    request.setOpt(new curlpp::options::HttpHeader(header));
+
+    request.setOpt(new curlpp::options::PostFields(rounds_json_string));
+    request.setOpt(new curlpp::options::PostFieldSize(-1));
+
+    request.perform();
+  }
+  catch (curlpp::LogicError &e) {
+    std::cout << e.what() << std::endl;
+  }
+  catch (curlpp::RuntimeError &e) {
+    std::cout << e.what() << std::endl;
+  }
+}
+
+} // !namespace
@@ -0,0 +1,77 @@
+/**
+ * Sends the visualization data of the rounds to the visualization server in the background (only built with
+ * BUILD_WITH_VISUALIZATION).
+ */
+
+#ifndef VIS_EXPORTER_H
+#define VIS_EXPORTER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace c1::peer {
+
+/** maximum number of rounds waiting for the exporter thread, the oldest round is dropped if another one arrives */
+constexpr size_t kVisQueueCapacity{64};
+/** maximum number of rounds sent with a single POST */
+constexpr size_t kVisMaxBatch{16};
+
+/**
+ * Owns a thread that converts the serialized VisData to JSON and POSTs it to the visualization server (as a JSON
+ * array of the rounds that have accumulated since the last POST). push() only copies the data, so neither a slow nor
+ * an absent visualization server delays the round.
+ */
+class VisExporter {
+ public:
+  /**
+   * Start the exporter thread.
+   * @param vis_ip ip of the visualization server (see visualization/visserver.py)
+   */
+  explicit VisExporter(const std::string &vis_ip);
+  /**
+   * Stop and join the exporter thread (the rounds that have not been sent yet are dropped).
+   */
+  ~VisExporter();
+  VisExporter(const VisExporter &) = delete;
+  VisExporter &operator=(const VisExporter &) = delete;
+
+  /**
+   * Enqueue the data of a round (never blocks).
+   * @param ptr serialized VisData
+   * @param len its length
+   */
+  void push(const uint8_t *ptr, size_t len);
+
+  /** @return the number of rounds dropped because the queue was full */
+  size_t num_dropped();
+
+ private:
+  /** body of the exporter thread */
+  void run();
+  /**
+   * Send a batch of rounds to the visualization server (exporter thread only).
+   * @param batch serialized VisData of each round
+   */
+  void post(const std::vector<std::vector<uint8_t>> &batch);
+
+  std::string url_;
+  std::mutex mutex_;
+  /** notified when queue_ is no longer empty or the exporter is stopped */
+  std::condition_variable cv_;
+  /** the rounds waiting for the exporter thread, the oldest first (guarded by mutex_) */
+  std::deque<std::vector<uint8_t>> queue_;
+  /** cleared to make the exporter thread terminate (guarded by mutex_) */
+  bool running_ = true;
+  size_t num_dropped_ = 0;
+  /** (started last, once the other members have been initialized) */
+  std::thread thread_;
+};
+
+} // !namespace
+
+#endif //VIS_EXPORTER_H
@@ -0,0 +1,51 @@
+#!/bin/bash
+# Author: Alexander S.
+# Starts a login server and a number of peers on this machine (e.g. to try out larger networks on a single host).
+# All processes are stopped when this script is interrupted. Output of the peers is written to $LOG_DIR/peer_<i>.log.
+#
+# usage: run_local_network.sh [-n num_peers] [-d dimension] [-m m_corrupt] [-r max_routing_out] [-t delta_ms]
+#                             [-a balanced|random] [-b build_dir] [-l log_dir] [-p login_server_port]
+
+NUM_PEERS=81
+DIMENSION=3
+M_CORRUPT=1
+MAX_ROUTING_OUT=10
+DELTA=4000
+ASSIGNMENT=balanced
+BUILD_DIR=build
+LOG_DIR=logs
+PORT=5671
+
+while getopts "n:d:m:r:t:a:b:l:p:" opt; do
+  case $opt in
+    n) NUM_PEERS=$OPTARG ;;
+    d) DIMENSION=$OPTARG ;;
+    m) M_CORRUPT=$OPTARG ;;
+    r) MAX_ROUTING_OUT=$OPTARG ;;
+    t) DELTA=$OPTARG ;;
+    a) ASSIGNMENT=$OPTARG ;;
+    b) BUILD_DIR=$OPTARG ;;
+    l) LOG_DIR=$OPTARG ;;
+    p) PORT=$OPTARG ;;
+    *) echo "usage: $0 [-n num_peers] [-d dimension] [-m m_corrupt] [-r max_routing_out] [-t delta_ms] [-a balanced|random] [-b build_dir] [-l log_dir] [-p port]"
+       exit 1 ;;
+  esac
+done
+
+# every peer holds sockets to all peers of its quorums and neighbouring quorums
+ulimit -n "$(ulimit -Hn)" 2>/dev/null
+
+mkdir -p "$LOG_DIR"
+trap 'kill $(jobs -p) 2>/dev/null' EXIT
+
+"$BUILD_DIR"/login_server/login_server -k "$NUM_PEERS" -d "$DIMENSION" -p "$PORT" \
+  --m-corrupt "$M_CORRUPT" --max-routing-out "$MAX_ROUTING_OUT" --delta "$DELTA" \
+  --assignment "$ASSIGNMENT" > "$LOG_DIR"/login_server.log 2>&1 &
+sleep 1
+
+for i in $(seq 1 "$NUM_PEERS"); do
+  "$BUILD_DIR"/peer/peer -p "$PORT" -l 127.0.0.1 -o 127.0.0.1 > "$LOG_DIR"/peer_"$i".log 2>&1 &
+done
+
+echo "Started login server and $NUM_PEERS peers (logs in $LOG_DIR), press Ctrl-C to stop."
+wait
@@ -5,9 +5,45 @@
 #define BOOST_TEST_MODULE StructureTest
 #include <boost/test/included/unit_test.hpp>
 #include "../peer/trusted/structs/aad_tuple.h"
+#include "../peer/trusted/structs/message_queue.h"
+#include "../peer/trusted/structs/message_tuple_set.h"
+#include "../peer/trusted/structs/peer_set.h"
+#include "../peer/trusted/routing_scheme.h"
+#include "../peer/trusted/threshold_counter.h"
+#include "../peer/untrusted/network/round_scheduler.h"
+#include "../peer/untrusted/network/shm_ring.h"
+#include "../peer/untrusted/network/udp_fragmentation.h"
+#include "../peer/untrusted/network/spsc_queue.h"
 
 using namespace boost::unit_test;
 
+// (called by the trusted code under test)
+extern "C" void ocall_print_string(const char *) {}
+
+namespace {
+
+/** a routing tuple of a message with text towards bucket (all tuples with the same bucket form one group) */
+c1::peer::RoutingSchemeTuple routing_tuple(uint8_t bucket, uint8_t text) {
+  uint8_t src[kPseudonymSize]{1};
+  uint8_t dst[kPseudonymSize]{bucket};
+  uint8_t msg[kMessageSize]{text};
+  c1::peer::MessageTuple m{c1::peer::Pseudonym{src}, c1::peer::Message{msg}, c1::peer::Pseudonym{dst}, 64};
+  return c1::peer::RoutingSchemeTuple{m, 3, c1::peer::Pseudonym{dst}, 4, 0};
+}
+
+/** the texts of the messages routed out of set_s (in the order of the result) */
+std::vector<uint8_t> routed_texts(std::vector<c1::peer::RoutingSchemeTuple> &set_s) {
+  tee_cmac_128bit_key_t sk_routing{};
+  // (l_dst = 4 is the first routing round for round 0 in dimension 2)
+  std::vector<uint8_t> result;
+  for (const auto &s : c1::peer::RoutingScheme::route(set_s, 0, 2, sk_routing)) {
+    result.push_back(s.m.m.get()[0]);
+  }
+  return result;
+}
+
+} // !namespace
+
 BOOST_AUTO_TEST_SUITE(peer_test_suite)
 
 BOOST_AUTO_TEST_CASE(number_serialization_test) {
@@ -34,4 +70,398 @@ BOOST_AUTO_TEST_CASE(aad_serialization_test) {
   BOOST_ASSERT(a1 == a2);
 }
 
+BOOST_AUTO_TEST_CASE(hand_over_message_serialization_test) {
+  c1::PeerInformation p1{3, c1::Uri(127, 0, 0, 1, 9999)};
+  c1::PeerInformation p2{12, c1::Uri(127, 0, 0, 1, 11111)};
+  c1::PeerInformation p3{40, c1::Uri(127, 0, 0, 2, 9999)};
+  std::map<onid_t, std::vector<c1::PeerInformation>> gamma_route{{0, {p1, p2}}, {1, {p2}}, {4, {}}};
+  auto m1 = c1::peer::OverlayStructureSchemeMessage::createHandOverMessage(gamma_route, {p1, p3});
+  auto m2 = c1::peer::OverlayStructureSchemeMessage::createSelfIntroduceMessage(p1);
+
+  std::vector<uint8_t> vec;
+  m1.serialize(vec);
+  m2.serialize(vec);
+  BOOST_ASSERT(vec.size() == m1.estimate_size() + m2.estimate_size());
+  size_t cur = 0;
+  auto m1_deserialized = c1::peer::OverlayStructureSchemeMessage::deserialize(vec, cur);
+  auto m2_deserialized = c1::peer::OverlayStructureSchemeMessage::deserialize(vec, cur);
+  BOOST_ASSERT(cur == vec.size());
+  BOOST_ASSERT(m1 == m1_deserialized);
+  BOOST_ASSERT(m2 == m2_deserialized);
+  BOOST_ASSERT(m1.digest() == m1_deserialized.digest());
+  BOOST_ASSERT(m1 != m2);
+
+  std::set<c1::peer::OverlayStructureSchemeMessage> in_structure{m1, m2, m1_deserialized};
+  BOOST_ASSERT(in_structure.size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(hand_over_message_unsorted_sets_test) {
+  c1::PeerInformation p1{3, c1::Uri(127, 0, 0, 1, 9999)};
+  c1::PeerInformation p2{12, c1::Uri(127, 0, 0, 1, 11111)};
+  c1::PeerInformation p3{40, c1::Uri(127, 0, 0, 2, 9999)};
+  std::map<onid_t, std::vector<c1::PeerInformation>> gamma_route{{0, {p3, p1, p2}}, {1, {p2, p1}}};
+  auto m1 = c1::peer::OverlayStructureSchemeMessage::createHandOverMessage(gamma_route, {p3, p1});
+  std::map<onid_t, std::vector<c1::PeerInformation>> gamma_route_sorted{{0, {p1, p2, p3}}, {1, {p1, p2}}};
+  auto m2 = c1::peer::OverlayStructureSchemeMessage::createHandOverMessage(gamma_route_sorted, {p1, p3});
+
+  std::vector<uint8_t> vec;
+  m1.serialize(vec);
+  size_t cur = 0;
+  auto m1_deserialized = c1::peer::OverlayStructureSchemeMessage::deserialize(vec, cur);
+  // the decoded sets are in table order, the message is still the same
+  BOOST_ASSERT(m1_deserialized.gamma_route.at(0) != m1.gamma_route.at(0));
+  BOOST_ASSERT(m1 == m1_deserialized);
+  BOOST_ASSERT(!(m1 < m1_deserialized) && !(m1_deserialized < m1));
+  BOOST_ASSERT(m1 == m2);
+
+  std::set<c1::peer::OverlayStructureSchemeMessage> in_structure{m1, m1_deserialized, m2};
+  BOOST_ASSERT(in_structure.size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(routing_scheme_groups_test) {
+  // three groups of one message each: every message is routed exactly once, in the same order for any input order
+  std::vector<c1::peer::RoutingSchemeTuple> set_s{routing_tuple(30, 3), routing_tuple(10, 1), routing_tuple(20, 2)};
+  auto texts = routed_texts(set_s);
+  BOOST_ASSERT(std::set<uint8_t>(texts.begin(), texts.end()) == (std::set<uint8_t>{1, 2, 3}));
+  BOOST_ASSERT(texts.size() == 3);
+  std::vector<c1::peer::RoutingSchemeTuple> set_s_permuted{set_s[2], set_s[0], set_s[1]};
+  BOOST_ASSERT(routed_texts(set_s_permuted) == texts);
+}
+
+BOOST_AUTO_TEST_CASE(routing_scheme_cancel_test) {
+  // a group exceeding k_recv is cancelled, wherever it ends up in the sorted order (also as the last group)
+  static_assert(kRecv == 2);
+  std::vector<c1::peer::RoutingSchemeTuple> oversized{routing_tuple(10, 1), routing_tuple(10, 2), routing_tuple(10, 3)};
+  BOOST_ASSERT(routed_texts(oversized).empty());
+
+  for (uint8_t other_bucket : {5, 15}) {
+    std::vector<c1::peer::RoutingSchemeTuple> set_s{routing_tuple(10, 1), routing_tuple(10, 2),
+                                                    routing_tuple(other_bucket, 4), routing_tuple(10, 3)};
+    BOOST_ASSERT(routed_texts(set_s) == std::vector<uint8_t>{4});
+  }
+
+  // a group containing M_cancel is cancelled as a whole, the other groups are not affected
+  auto cancel = routing_tuple(10, 0);
+  std::vector<c1::peer::RoutingSchemeTuple> set_s{
+      routing_tuple(10, 1),
+      c1::peer::RoutingSchemeTuple{c1::peer::MessageTuple::create_cancel(), cancel.onid_dst, cancel.bucket_dst,
+                                   cancel.l_dst, cancel.onid_current},
+      routing_tuple(20, 2)};
+  BOOST_ASSERT(routed_texts(set_s) == std::vector<uint8_t>{2});
+}
+
+BOOST_AUTO_TEST_CASE(agreement_tuple_serialization_test) {
+  uint8_t src[kPseudonymSize]{1};
+  uint8_t dst[kPseudonymSize]{2};
+  uint8_t text[kMessageSize]{3};
+  c1::peer::AgreementTuple a1{
+      c1::peer::MessageTuple{c1::peer::Pseudonym{src}, c1::peer::Message{text}, c1::peer::Pseudonym{dst}, 64},
+      5, 72, 7};
+  std::vector<uint8_t> vec;
+  a1.serialize(vec);
+  BOOST_ASSERT(vec.size() == a1.estimate_size());
+  size_t cur = 0;
+  auto a2 = c1::peer::AgreementTuple::deserialize(vec, cur);
+  BOOST_ASSERT(cur == vec.size());
+  BOOST_ASSERT(a1.m == a2.m && a1.onid_src == a2.onid_src && a1.s == a2.s && a1.l == a2.l);
+}
+
+BOOST_AUTO_TEST_CASE(message_tuple_digest_test) {
+  uint8_t src[kPseudonymSize]{1};
+  uint8_t dst[kPseudonymSize]{2};
+  uint8_t text[kMessageSize]{3};
+  c1::peer::MessageTuple m1{c1::peer::Pseudonym{src}, c1::peer::Message{text}, c1::peer::Pseudonym{dst}, 4711};
+  c1::peer::MessageTuple m2{c1::peer::Pseudonym{src}, c1::peer::Message{text}, c1::peer::Pseudonym{dst}, 4711};
+  c1::peer::MessageTuple m3{c1::peer::Pseudonym{src}, c1::peer::Message{text}, c1::peer::Pseudonym{dst}, 4712};
+  text[kMessageSize - 1] = 1;
+  c1::peer::MessageTuple m4{c1::peer::Pseudonym{src}, c1::peer::Message{text}, c1::peer::Pseudonym{dst}, 4711};
+
+  BOOST_ASSERT(m1.digest() == m2.digest());
+  BOOST_ASSERT(m1 == m2);
+  BOOST_ASSERT(m1.digest() != m3.digest());
+  BOOST_ASSERT(m1 != m3);
+  BOOST_ASSERT(m1.digest() != m4.digest());
+  BOOST_ASSERT(m1 != m4);
+
+  // the digest is recomputed on decode
+  std::vector<uint8_t> vec;
+  m4.serialize(vec);
+  size_t cur = 0;
+  auto m4_deserialized = c1::peer::MessageTuple::deserialize(vec, cur);
+  BOOST_ASSERT(m4_deserialized.digest() == m4.digest());
+  BOOST_ASSERT(m4_deserialized == m4);
+}
+
+BOOST_AUTO_TEST_CASE(message_tuple_set_test) {
+  uint8_t src[kPseudonymSize]{1};
+  uint8_t dst[kPseudonymSize]{2};
+  uint8_t text1[kMessageSize]{3};
+  uint8_t text2[kMessageSize]{4};
+  // two distinct messages with the same delivery time, one of them received twice, plus padding
+  std::vector<c1::peer::MessageTuple> deliver{
+      c1::peer::MessageTuple{c1::peer::Pseudonym{src}, c1::peer::Message{text1}, c1::peer::Pseudonym{dst}, 64},
+      c1::peer::MessageTuple{c1::peer::Pseudonym{src}, c1::peer::Message{text2}, c1::peer::Pseudonym{dst}, 64},
+      c1::peer::MessageTuple{c1::peer::Pseudonym{src}, c1::peer::Message{text1}, c1::peer::Pseudonym{dst}, 64},
+      c1::peer::MessageTuple::create_dummy(),
+      c1::peer::MessageTuple::create_dummy()};
+
+  c1::peer::MessageTupleSet set;
+  set.insert(deliver.begin(), deliver.end());
+  BOOST_ASSERT(set.size() == 2);
+  BOOST_ASSERT(set.contains(deliver[0]));
+  BOOST_ASSERT(set.contains(deliver[1]));
+  BOOST_ASSERT(!set.contains(deliver[3]));
+
+  set.insert(deliver.begin(), deliver.begin() + 2);
+  BOOST_ASSERT(set.size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(message_queue_test) {
+  uint8_t src[kPseudonymSize]{1};
+  uint8_t dst[kPseudonymSize]{2};
+  uint8_t text1[kMessageSize]{3};
+  uint8_t text2[kMessageSize]{4};
+  c1::peer::MessageTuple late{c1::peer::Pseudonym{src}, c1::peer::Message{text1}, c1::peer::Pseudonym{dst}, 80};
+  c1::peer::MessageTuple early{c1::peer::Pseudonym{src}, c1::peer::Message{text2}, c1::peer::Pseudonym{dst}, 64};
+
+  std::vector<c1::peer::MessageQueue> queues(1);
+  BOOST_ASSERT(queues[0].push(late));
+  BOOST_ASSERT(!queues[0].push(late));
+  BOOST_ASSERT(queues[0].push(early));
+  queues.resize(8); // moving the queue must keep it intact
+  auto &q_in = queues[0];
+  BOOST_ASSERT(q_in.size() == 2);
+  BOOST_ASSERT(q_in.top() == early);
+  q_in.pop();
+  BOOST_ASSERT(!q_in.contains(early));
+  BOOST_ASSERT(q_in.top() == late);
+  q_in.pop();
+  BOOST_ASSERT(q_in.empty());
+}
+
+BOOST_AUTO_TEST_CASE(peer_set_test) {
+  c1::PeerInformation p1{3, c1::Uri(127, 0, 0, 1, 9999)};
+  c1::PeerInformation p2{12, c1::Uri(127, 0, 0, 1, 11111)};
+  c1::peer::PeerSet set(std::vector<c1::PeerInformation>{p2, p1, p2});
+  BOOST_ASSERT(set.size() == 2);
+  BOOST_ASSERT(set.peers().at(0) == p2); // keeps the order of insertion
+  BOOST_ASSERT(set.contains(3) && set.contains(12) && !set.contains(4) && !set.contains(100));
+  BOOST_ASSERT(!set.insert(p1));
+
+  set.clear();
+  BOOST_ASSERT(set.empty() && !set.contains(3));
+  BOOST_ASSERT(set.insert(p1));
+}
+
+BOOST_AUTO_TEST_CASE(threshold_counter_test) {
+  uint8_t src[kPseudonymSize]{1};
+  uint8_t dst[kPseudonymSize]{2};
+  uint8_t text1[kMessageSize]{3};
+  uint8_t text2[kMessageSize]{4};
+  c1::peer::MessageTuple m1{c1::peer::Pseudonym{src}, c1::peer::Message{text1}, c1::peer::Pseudonym{dst}, 64};
+  c1::peer::MessageTuple m2{c1::peer::Pseudonym{src}, c1::peer::Message{text2}, c1::peer::Pseudonym{dst}, 64};
+  // m1 and m2 only differ in their message (so an ordering on t_dst would not tell them apart)
+  std::vector<c1::peer::MessageTuple> in{m1, m2, m1, m2, m1, c1::peer::MessageTuple::create_dummy()};
+
+  c1::peer::ThresholdCounter counter;
+  auto result = counter.exceeding(in, 2);
+  BOOST_ASSERT(result.size() == 1);
+  BOOST_ASSERT(result[0].get() == m1);
+
+  // the counter is reset between calls
+  result = counter.exceeding(in, 1);
+  BOOST_ASSERT(result.size() == 2);
+  BOOST_ASSERT(result[0].get() == m1);
+  BOOST_ASSERT(result[1].get() == m2);
+}
+
+BOOST_AUTO_TEST_CASE(spsc_queue_test) {
+  c1::peer::SpscQueue<std::vector<uint8_t>> queue(3);
+  BOOST_ASSERT(queue.capacity() == 4);
+  std::vector<uint8_t> element{1, 2, 3};
+  for (int i = 0; i < 4; ++i) {
+    auto copy = element;
+    BOOST_ASSERT(queue.try_push(copy));
+  }
+  BOOST_ASSERT(!queue.try_push(element));
+  BOOST_ASSERT(element.size() == 3); // not moved from if the queue is full
+  std::vector<uint8_t> popped;
+  while (queue.try_pop(popped)) {
+    BOOST_ASSERT(popped == element);
+  }
+  BOOST_ASSERT(queue.empty());
+
+  // one producer and one consumer thread, the elements have to arrive complete and in order
+  c1::peer::SpscQueue<size_t> numbers(64);
+  constexpr size_t kNumElements = 100000;
+  std::thread producer([&numbers] {
+    for (size_t i = 0; i < kNumElements; ++i) {
+      for (size_t value = i; !numbers.try_push(value);) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  size_t expected = 0;
+  for (size_t value; expected < kNumElements;) {
+    if (numbers.try_pop(value)) {
+      BOOST_ASSERT(value == expected);
+      ++expected;
+    }
+  }
+  producer.join();
+  BOOST_ASSERT(numbers.empty());
+}
+
+BOOST_AUTO_TEST_CASE(round_scheduler_test) {
+  c1::peer::RoundScheduler scheduler;
+  BOOST_ASSERT(scheduler.wait(false) == c1::peer::RoundScheduler::kNone);
+
+  // a notification from another thread wakes up the blocking wait
+  std::thread producer([&scheduler] { scheduler.notify(); });
+  BOOST_ASSERT(scheduler.wait(true) == c1::peer::RoundScheduler::kWork);
+  producer.join();
+  BOOST_ASSERT(scheduler.wait(false) == c1::peer::RoundScheduler::kNone);
+
+  // notifying twice before the wait only wakes up once
+  scheduler.notify();
+  scheduler.notify();
+  BOOST_ASSERT(scheduler.wait(false) == c1::peer::RoundScheduler::kWork);
+  BOOST_ASSERT(scheduler.wait(false) == c1::peer::RoundScheduler::kNone);
+
+  auto round_start = std::chrono::system_clock::now() + std::chrono::milliseconds(20);
+  scheduler.schedule_round(round_start);
+  BOOST_ASSERT(scheduler.wait(false) == c1::peer::RoundScheduler::kNone);
+  BOOST_ASSERT(scheduler.wait(true) == c1::peer::RoundScheduler::kRoundDue);
+  BOOST_ASSERT(std::chrono::system_clock::now() >= round_start);
+  BOOST_ASSERT(scheduler.wait(false) == c1::peer::RoundScheduler::kNone); // the timer fires only once
+}
+
+BOOST_AUTO_TEST_CASE(shm_ring_test) {
+  constexpr size_t kCapacity = 64;
+  std::vector<uint64_t> memory(c1::peer::ShmRing::required_size(kCapacity) / sizeof(uint64_t) + 8);
+  auto ring = c1::peer::ShmRing::create(memory.data(), kCapacity);
+  BOOST_ASSERT(ring.empty());
+
+  // frames of 8 + 24 bytes: the third frame has to wrap around once the first two have been consumed
+  std::vector<uint8_t> frame(20);
+  std::vector<uint8_t> received;
+  auto consume = [&received](const uint8_t *data, size_t len) { received.assign(data, data + len); };
+  for (uint8_t i = 0; i < 10; ++i) {
+    std::fill(frame.begin(), frame.end(), i);
+    BOOST_ASSERT(ring.try_push(frame.data(), frame.size()));
+    if (i % 2 == 0) {
+      continue;
+    }
+    BOOST_ASSERT(!ring.try_push(frame.data(), frame.size())); // full
+    for (uint8_t j = i - 1; j <= i; ++j) {
+      BOOST_ASSERT(ring.try_pop(consume));
+      BOOST_ASSERT(received == std::vector<uint8_t>(20, j));
+    }
+  }
+  BOOST_ASSERT(!ring.try_pop(consume));
+
+  // the other side of the link only attaches to the ring
+  auto receiver = c1::peer::ShmRing::attach(memory.data());
+  BOOST_ASSERT(ring.try_push(frame.data(), 3));
+  BOOST_ASSERT(receiver.try_pop(consume) && received.size() == 3);
+  BOOST_ASSERT(!ring.try_push(frame.data(), kCapacity)); // never fits
+}
+
+BOOST_AUTO_TEST_CASE(udp_reassembler_test) {
+  using c1::peer::kUdpFragmentPayload;
+  using c1::peer::UdpFragmentHeader;
+  // split a frame into datagrams the way UdpTransport does
+  auto fragment = [](const std::vector<uint8_t> &frame, uint32_t message_id) {
+    auto count = static_cast<uint16_t>(c1::peer::udp_num_fragments(frame.size()));
+    std::vector<std::vector<uint8_t>> datagrams;
+    for (uint16_t index = 0; index < count; ++index) {
+      UdpFragmentHeader header{message_id, index, count};
+      auto begin = frame.begin() + index * kUdpFragmentPayload;
+      auto end = frame.begin() + std::min(frame.size(), (index + 1) * kUdpFragmentPayload);
+      std::vector<uint8_t> datagram(reinterpret_cast<uint8_t *>(&header),
+                                    reinterpret_cast<uint8_t *>(&header) + sizeof(header));
+      datagram.insert(datagram.end(), begin, end);
+      datagrams.push_back(datagram);
+    }
+    return datagrams;
+  };
+
+  c1::peer::UdpReassembler reassembler(c1::peer::kUdpMaxFrameSize);
+  std::vector<std::vector<uint8_t>> received;
+  auto consume = [&received](const uint8_t *data, size_t len) { received.emplace_back(data, data + len); };
+
+  std::vector<uint8_t> small(100, 1);
+  std::vector<uint8_t> large(3 * kUdpFragmentPayload + 17);
+  for (size_t i = 0; i < large.size(); ++i) {
+    large[i] = static_cast<uint8_t>(i);
+  }
+  auto small_datagrams = fragment(small, 1);
+  auto large_datagrams = fragment(large, 2);
+  BOOST_ASSERT(small_datagrams.size() == 1 && large_datagrams.size() == 4);
+
+  // out of order, with a duplicate and the other sender's datagram in between
+  for (auto index : {3, 1, 1, 0}) {
+    BOOST_ASSERT(reassembler.add(7, large_datagrams[index].data(), large_datagrams[index].size(), consume));
+  }
+  BOOST_ASSERT(reassembler.add(8, small_datagrams[0].data(), small_datagrams[0].size(), consume));
+  BOOST_ASSERT(received.size() == 1 && received[0] == small);
+  BOOST_ASSERT(reassembler.add(7, large_datagrams[2].data(), large_datagrams[2].size(), consume));
+  BOOST_ASSERT(received.size() == 2 && received[1] == large);
+  BOOST_ASSERT(reassembler.num_partial_frames() == 0);
+
+  // malformed: too short, index out of range
+  BOOST_ASSERT(!reassembler.add(7, large_datagrams[0].data(), 3, consume));
+  UdpFragmentHeader header{3, 2, 2};
+  BOOST_ASSERT(!reassembler.add(7, reinterpret_cast<uint8_t *>(&header), sizeof(header), consume));
+
+  // frames that are never completed are dropped eventually
+  for (uint32_t message_id = 10; message_id < 10 + 2 * c1::peer::kUdpMaxPartialFrames; ++message_id) {
+    auto datagrams = fragment(large, message_id);
+    reassembler.add(7, datagrams[0].data(), datagrams[0].size(), consume);
+  }
+  BOOST_ASSERT(reassembler.num_partial_frames() == c1::peer::kUdpMaxPartialFrames);
+  BOOST_ASSERT(received.size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(udp_reassembler_limits_test) {
+  using c1::peer::kUdpFragmentPayload;
+  using c1::peer::UdpFragmentHeader;
+  auto datagram = [](uint32_t message_id, uint16_t index, uint16_t count) {
+    UdpFragmentHeader header{message_id, index, count};
+    std::vector<uint8_t> result(reinterpret_cast<uint8_t *>(&header),
+                                reinterpret_cast<uint8_t *>(&header) + sizeof(header));
+    result.resize(sizeof(header) + kUdpFragmentPayload, 1);
+    return result;
+  };
+  auto consume = [](const uint8_t *, size_t) {};
+
+  // frames with more fragments than the largest frame are malformed (nothing is allocated for them)
+  c1::peer::UdpReassembler reassembler(4 * kUdpFragmentPayload);
+  auto oversized = datagram(1, 0, UINT16_MAX);
+  BOOST_ASSERT(!reassembler.add(7, oversized.data(), oversized.size(), consume));
+  auto too_many = datagram(1, 0, 5);
+  BOOST_ASSERT(!reassembler.add(7, too_many.data(), too_many.size(), consume));
+  BOOST_ASSERT(reassembler.num_partial_frames() == 0 && reassembler.partial_bytes() == 0);
+
+  // the buffer grows with the fragments
+  auto first = datagram(1, 0, 4);
+  BOOST_ASSERT(reassembler.add(7, first.data(), first.size(), consume));
+  BOOST_ASSERT(reassembler.partial_bytes() < 2 * kUdpFragmentPayload);
+
+  // incomplete frames expire at the end of the round after the one they were started in
+  reassembler.next_round();
+  BOOST_ASSERT(reassembler.num_partial_frames() == 1);
+  reassembler.next_round();
+  BOOST_ASSERT(reassembler.num_partial_frames() == 0 && reassembler.partial_bytes() == 0);
+
+  // many senders cannot exceed the memory budget (it is raised to one frame of the largest size)
+  c1::peer::UdpReassembler budgeted(4 * kUdpFragmentPayload, 0);
+  for (uint64_t sender = 0; sender < 1000; ++sender) {
+    auto last = datagram(1, 3, 4);
+    BOOST_ASSERT(budgeted.add(sender, last.data(), last.size(), consume));
+  }
+  BOOST_ASSERT(budgeted.num_partial_frames() == 1);
+  BOOST_ASSERT(budgeted.partial_bytes() <= 5 * kUdpFragmentPayload);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
\ No newline at end of file
@@ -40,17 +40,6 @@ BOOST_AUTO_TEST_CASE(join_message_via_message_serializer_test) {
 
 
 BOOST_AUTO_TEST_CASE(init_message_test) {
-  std::vector<c1::PeerInformation> gamma_send;
-  std::vector<c1::PeerInformation> gamma_receive;
-  std::map<uint64_t, std::vector<c1::PeerInformation>> gamma_route;
-
-  gamma_send.push_back(c1::PeerInformation{12, c1::Uri(127, 0, 0, 1, 9999)});
-  gamma_route[13] = std::vector<c1::PeerInformation>();
-  c1::PeerInformation pi1(c1::PeerInformation{72, c1::Uri(127, 0, 0, 1, 11111)});
-  gamma_route[13].push_back(pi1);
-  gamma_route[19] = std::vector<c1::PeerInformation>();
-  gamma_route[19].push_back(c1::PeerInformation{3, c1::Uri(127, 0, 0, 1, 9876)});
-
   //Test keys
   std::array<uint8_t, kTee_aesgcm_key_size> sk_pseud;
   std::array<uint8_t, kTee_aesgcm_key_size> sk_enc;
@@ -67,21 +56,17 @@ BOOST_AUTO_TEST_CASE(init_message_test) {
   sk_routing[0] = 3;
 
 
-  c1::InitMessage im(1, 20, 5, 1, 3, gamma_send, gamma_receive,
-      gamma_route,
-      sk_pseud, sk_enc, sk_routing);
+  c1::InitMessage im(1, 20, 5, 2, 0, 50, 1700000000000, 1, 3, sk_pseud, sk_enc, sk_routing);
 
   BOOST_ASSERT(im.get_receiver_id_() == 1);
   BOOST_ASSERT(im.get_num_total_nodes_() == 20);
   BOOST_ASSERT(im.get_overlay_dimension_() == 5);
+  BOOST_ASSERT(im.get_m_corrupt_() == 2);
+  BOOST_ASSERT(im.get_max_routing_out_() == 0);
+  BOOST_ASSERT(im.get_delta_() == 50);
+  BOOST_ASSERT(im.get_start_time_() == 1700000000000);
   BOOST_ASSERT(im.get_onid_assoc_() == 1);
   BOOST_ASSERT(im.get_onid_emul_() == 3);
-  BOOST_ASSERT(im.get_gamma_send_().size() == 1);
-  BOOST_ASSERT(im.get_gamma_send_().at(0).id == 12);
-  BOOST_ASSERT(im.get_gamma_send_().at(0).uri == c1::Uri(127, 0, 0, 1, 9999));
-  BOOST_ASSERT(im.get_gamma_route_().size() == 2);
-  BOOST_ASSERT(im.get_gamma_route_().at(13).size() == 1);
-  BOOST_ASSERT(im.get_gamma_route_().at(19).size() == 1);
   BOOST_ASSERT(im.get_sk_pseud_()[0] == 1);
   BOOST_ASSERT(im.get_sk_enc_()[0] == 2);
   BOOST_ASSERT(im.get_sk_routing_()[0] == 3);
@@ -100,22 +85,52 @@ BOOST_AUTO_TEST_CASE(init_message_test) {
   BOOST_ASSERT(im_deserialized.get_receiver_id_() == 1);
   BOOST_ASSERT(im_deserialized.get_num_total_nodes_() == 20);
   BOOST_ASSERT(im_deserialized.get_overlay_dimension_() == 5);
+  BOOST_ASSERT(im_deserialized.get_m_corrupt_() == 2);
+  BOOST_ASSERT(im_deserialized.get_max_routing_out_() == 0);
+  BOOST_ASSERT(im_deserialized.get_delta_() == 50);
+  BOOST_ASSERT(im_deserialized.get_start_time_() == 1700000000000);
   BOOST_ASSERT(im_deserialized.get_onid_assoc_() == 1);
   BOOST_ASSERT(im_deserialized.get_onid_emul_() == 3);
-  BOOST_ASSERT(im_deserialized.get_gamma_send_().size() == 1);
-  BOOST_ASSERT(im_deserialized.get_gamma_send_().at(0).id == 12);
-  BOOST_ASSERT(im_deserialized.get_gamma_send_().at(0).uri == c1::Uri(127, 0, 0, 1, 9999));
-  BOOST_ASSERT(im_deserialized.get_gamma_receive_().size() == 0);
-  BOOST_ASSERT(im_deserialized.get_gamma_route_().size() == 2);
-  BOOST_ASSERT(im_deserialized.get_gamma_route_().at(13).size() == 1);
-  BOOST_ASSERT(im_deserialized.get_gamma_route_().at(13).at(0) == pi1);
-  BOOST_ASSERT(im_deserialized.get_gamma_route_().at(19).size() == 1);
   BOOST_ASSERT(im_deserialized.get_sk_pseud_()[0] == 1);
   BOOST_ASSERT(im_deserialized.get_sk_enc_()[0] == 2);
   BOOST_ASSERT(im_deserialized.get_sk_routing_()[0] == 3);
 
 }
 
+BOOST_AUTO_TEST_CASE(topology_message_test) {
+  // dimension 1: quorums 0 and 1; peers 0-2 are associated to quorum 0, peers 3 and 4 to quorum 1
+  std::vector<c1::Uri> uris;
+  for (uint64_t port = 9000; port < 9005; ++port) {
+    uris.emplace_back(127, 0, 0, 1, port);
+  }
+  c1::TopologyMessage tm(uris, {0, 0, 0, 1, 1}, {1, 0, 1, 0, 1});
+
+  std::vector<uint8_t> tm_serialized;
+  c1::MessageSerializer::serialize_message(tm, tm_serialized);
+  size_t cur = 0;
+  auto tm_deserialized_var = c1::MessageSerializer::deserialize_message(tm_serialized, cur);
+  BOOST_ASSERT(cur == tm_serialized.size());
+  BOOST_ASSERT(std::holds_alternative<c1::TopologyMessage>(tm_deserialized_var));
+  auto &tm_deserialized = std::get<c1::TopologyMessage>(tm_deserialized_var);
+  BOOST_ASSERT(tm_deserialized.get_num_peers() == 5);
+  BOOST_ASSERT(tm_deserialized.get_uris_() == uris);
+  BOOST_ASSERT(tm_deserialized.get_emulated_quorums_() == tm.get_emulated_quorums_());
+
+  // the gamma sets of peer 0 (associated to quorum 0, emulates quorum 1)
+  std::vector<c1::PeerInformation> gamma_send;
+  std::vector<c1::PeerInformation> gamma_receive;
+  std::map<onid_t, std::vector<c1::PeerInformation>> gamma_route;
+  tm_deserialized.get_gamma_sets(0, 1, 1, gamma_send, gamma_receive, gamma_route);
+  BOOST_ASSERT(gamma_send.size() == 2); // peers 1 and 3 emulate quorum 0
+  BOOST_ASSERT(gamma_send.at(0) == c1::PeerInformation(1, c1::Uri(127, 0, 0, 1, 9001)));
+  BOOST_ASSERT(gamma_send.at(1).id == 3);
+  BOOST_ASSERT(gamma_receive.size() == 2); // peers 3 and 4 are associated to quorum 1
+  BOOST_ASSERT(gamma_receive.at(0).id == 3 && gamma_receive.at(1).id == 4);
+  BOOST_ASSERT(gamma_route.size() == 2);
+  BOOST_ASSERT(gamma_route.at(1).size() == 3); // peers 0, 2 and 4 emulate quorum 1
+  BOOST_ASSERT(gamma_route.at(0) == gamma_send);
+}
+
 BOOST_AUTO_TEST_CASE(peer_information_serialization_test) {
   c1::PeerInformation pi{12, c1::Uri(127, 0, 0, 1, 9999)};
   std::vector<uint8_t> vec;
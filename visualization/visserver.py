@@ -82,7 +82,9 @@ class VisDataResource(object): #collects requests and forwards them to visualize
     def on_post(self, req, resp):
         data = ujson.load(req.bounded_stream)
         #parseAndForward(data)
-        queue.put(data)
+        #the peers send the data of several rounds at once
+        for round_data in (data if isinstance(data, list) else [data]):
+            queue.put(round_data)
         resp.status = falcon.HTTP_200
         resp.body = "Received the data."
 